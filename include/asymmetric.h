@@ -0,0 +1,67 @@
+#pragma once
+#include "metric.h"
+#include "quantized.h"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace route_opt {
+
+// Local search that is correct for asymmetric distance matrices such as the
+// ones produced by RouteGenerator::generateRoadNetwork. No move assumes
+// d(a,b) == d(b,a): Or-opt inserts segments in either orientation, and
+// 2-opt prices the reversed path from cached prefix sums of the forward and
+// backward edge costs along the tour instead of treating it as free.
+template <typename Metric>
+class AsymmetricLocalSearch {
+public:
+  using value_type = typename Metric::value_type;
+
+  // Candidate lists, the working tour and move scratch are allocated from
+  // `memory`, so a search on a SolverWorkspace takes nothing from the heap
+  // once the workspace has grown to the problem size.
+  AsymmetricLocalSearch(const Metric& metric, size_t k = 8, size_t maxSegmentLength = 3,
+                        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+  void improve(std::vector<int>& tour);
+
+  // Nearest-neighbour start tour from node 0 following outgoing distances.
+  std::vector<int> nearestNeighborTour() const;
+
+private:
+  static constexpr value_type kEpsilon = improvementEpsilon<Metric>();
+
+  Metric metric_;
+  const int n_;
+  const size_t k_;
+  const size_t maxSegmentLength_;
+
+  // Row v lists the k closest nodes reached from v (out) and reaching v (in).
+  std::pmr::vector<int> outNeighbors_;
+  std::pmr::vector<int> inNeighbors_;
+
+  std::pmr::vector<int> tour_;
+  std::pmr::vector<int> pos_;
+  // forward_[i] is the cost of tour_[0] -> ... -> tour_[i]; backward_[i] the
+  // cost of walking the same positions in reverse.
+  std::pmr::vector<double> forward_;
+  std::pmr::vector<double> backward_;
+  // Or-opt scratch: the moved segment and the tour being rebuilt.
+  std::pmr::vector<int> segment_;
+  std::pmr::vector<int> next_;
+
+  int at(int position) const { return tour_[(position % n_ + n_) % n_]; }
+  value_type dist(int a, int b) const { return metric_(a, b); }
+
+  void refresh();
+  double forwardCost(int from, int to) const;
+  double backwardCost(int from, int to) const;
+  bool tryTwoOpt(int i);
+  bool tryOrOpt(int s);
+};
+
+extern template class AsymmetricLocalSearch<MatrixMetric>;
+extern template class AsymmetricLocalSearch<Int32MatrixMetric>;
+extern template class AsymmetricLocalSearch<UInt16MatrixMetric>;
+
+}; // namespace route_opt
@@ -0,0 +1,138 @@
+#pragma once
+#include "types.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace route_opt {
+
+// Raw byte encoding for checkpoint payloads. Values are stored in native
+// byte order, so a checkpoint is only portable between machines of the same
+// endianness.
+class BinaryWriter {
+public:
+  template <typename T>
+  void write(const T& value) {
+    write(&value, 1);
+  }
+
+  template <typename T>
+  void write(const T* values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>, "BinaryWriter requires a trivially copyable type");
+    const auto* bytes = reinterpret_cast<const char*>(values);
+    data_.insert(data_.end(), bytes, bytes + count * sizeof(T));
+  }
+
+  void writeString(const std::string& value) {
+    write<uint64_t>(value.size());
+    write(value.data(), value.size());
+  }
+
+  const std::vector<char>& data() const { return data_; }
+
+private:
+  std::vector<char> data_;
+};
+
+class BinaryReader {
+public:
+  explicit BinaryReader(const std::vector<char>& data) : data_(data) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    read(&value, 1);
+    return value;
+  }
+
+  template <typename T>
+  void read(T* values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>, "BinaryReader requires a trivially copyable type");
+    const size_t bytes = count * sizeof(T);
+    if (bytes > data_.size() - offset_) {
+      throw std::runtime_error("Truncated checkpoint");
+    }
+    std::memcpy(values, data_.data() + offset_, bytes);
+    offset_ += bytes;
+  }
+
+  std::string readString() {
+    std::string value(read<uint64_t>(), '\0');
+    read(value.data(), value.size());
+    return value;
+  }
+
+  bool atEnd() const { return offset_ == data_.size(); }
+
+private:
+  const std::vector<char>& data_;
+  size_t offset_ = 0;
+};
+
+// State handed to a CheckpointWriter. encode() runs on the writer thread, so
+// everything it reads must stay unmodified until done() returns true; data
+// that changes on the hot path should be copied into the snapshot or left
+// in place and treated as copy-on-write by the producer.
+class Snapshot {
+public:
+  virtual ~Snapshot() = default;
+
+  virtual void encode(BinaryWriter& out) const = 0;
+
+  bool done() const { return done_.load(std::memory_order_acquire); }
+
+private:
+  friend class CheckpointWriter;
+  std::atomic<bool> done_{false};
+};
+
+// Writes snapshots to `path` on a background thread. The file is written
+// next to `path` and renamed over it, so a crash mid-write leaves the
+// previous checkpoint intact. A write error is rethrown by the next
+// submit().
+class CheckpointWriter {
+public:
+  explicit CheckpointWriter(std::string path);
+  // Finishes the snapshot being written, if any.
+  ~CheckpointWriter();
+
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+  // Hands `snapshot` to the writer thread and returns immediately. Returns
+  // false, without taking the snapshot, while an earlier one is unfinished.
+  bool submit(std::shared_ptr<Snapshot> snapshot);
+
+private:
+  const std::string path_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::shared_ptr<Snapshot> pending_;
+  std::exception_ptr error_;
+  bool stop_ = false;
+  std::thread thread_;
+
+  void run();
+};
+
+// Checkpoint files wrap the payload in a header with a magic number, format
+// version, size and checksum; readCheckpoint() rejects files that fail any
+// of these checks.
+void writeCheckpoint(const std::string& path, const std::vector<char>& payload);
+std::vector<char> readCheckpoint(const std::string& path);
+
+// Hash of the coordinates, stored in checkpoints so that one is never
+// resumed on a different instance.
+uint64_t fingerprint(const PointVector& points);
+
+}; // namespace route_opt
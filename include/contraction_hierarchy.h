@@ -0,0 +1,59 @@
+#pragma once
+#include "quantized.h"
+#include "road_graph.h"
+#include <cstddef>
+#include <vector>
+
+namespace route_opt {
+
+// Contraction hierarchy over a RoadGraph. Preprocessing removes nodes one at
+// a time, least important first, and adds a shortcut arc wherever removing a
+// node would lengthen a shortest path between its remaining neighbours.
+// Afterwards every shortest path climbs and then descends in contraction
+// order, so a query only searches upwards from both of its ends.
+class ContractionHierarchy {
+public:
+  explicit ContractionHierarchy(const RoadGraph& graph);
+
+  // Travel times from every source node to every target node as a
+  // sources.size() x targets.size() matrix; unreachable pairs are infinity.
+  // Bucket many-to-many: one backward search per target leaves its distance
+  // in a bucket at every node it reaches, then one forward search per source
+  // combines its distances with the buckets it meets. Both passes run in
+  // parallel.
+  std::vector<std::vector<double>> manyToMany(const std::vector<int>& sources,
+                                              const std::vector<int>& targets) const;
+
+  // Travel times between every pair of `nodes`, quantized row by row as the
+  // forward searches finish, so only one row of doubles per thread exists
+  // at a time. Throws std::runtime_error if a pair is unreachable.
+  QuantizedMatrix manyToMany(const std::vector<int>& nodes, DistancePrecision precision,
+                             double quantum) const;
+
+  size_t nodeCount() const { return rank_.size(); }
+  size_t shortcutCount() const { return shortcuts_; }
+
+private:
+  // Arcs towards higher-ranked nodes, in CSR form indexed by rank.
+  struct UpwardGraph {
+    std::vector<int> offsets;
+    std::vector<int> heads;
+    std::vector<double> weights;
+  };
+
+  // Contraction order of each graph node. Searches run on nodes renumbered
+  // by rank, so the upper levels they concentrate on sit together in memory.
+  std::vector<int> rank_;
+  // forward_ holds u -> w at u; backward_ holds w -> u at u, with head w.
+  UpwardGraph forward_;
+  UpwardGraph backward_;
+  size_t shortcuts_ = 0;
+
+  // Runs the bucket query and calls emit(i, row) from the worker threads
+  // with the targets.size() distances from sources[i].
+  template <typename Emit>
+  void forEachRow(const std::vector<int>& sources, const std::vector<int>& targets,
+                  Emit&& emit) const;
+};
+
+}; // namespace route_opt
@@ -1,6 +1,9 @@
 #pragma once
 #include "optimizer.h"
+#include "cuda/workspace.cuh"
 #include <thrust/device_vector.h>
+#include <random>
+#include <vector>
 
 namespace route_opt {
     namespace cuda {
@@ -9,12 +12,26 @@ namespace route_opt {
             virtual ~CUDAOptimizer() = default;
 
         protected:
-            thrust::device_vector<double> prepareDistances(const PointVector &points);
+            // The returned buffers belong to the optimizer and are reused by
+            // the next solve; host staging comes from `workspace`.
+            const thrust::device_vector<double> &prepareDistances(const PointVector &points,
+                                                                  SolverWorkspace &workspace);
 
-            thrust::device_vector<int> initializeRoute(int size);
+            const thrust::device_vector<double> &prepareDistances(const std::vector<std::vector<double>> &distances,
+                                                                  SolverWorkspace &workspace);
+
+            thrust::device_vector<int> &initializeRoute(int size, SolverWorkspace &workspace);
 
             double computeTotalDistance(const thrust::device_vector<double> &distances,
                                         const thrust::device_vector<int> &routes);
+
+            // Temporary storage for thrust algorithms: thrust::cuda::par(pool_).
+            DevicePool pool_;
+
+        private:
+            thrust::device_vector<double> distances_d_;
+            thrust::device_vector<int> route_d_;
+            std::mt19937 rng_{std::random_device{}()};
         };
 
         namespace factory {
@@ -22,6 +39,8 @@ namespace route_opt {
                 TwoOpt,
                 SimulatedAnnealing,
                 AntColony,
+                Decomposition,
+                Memetic,
             };
 
             RouteOptimizer *createCUDAOptimizer(RouteAlgorithm algo);
@@ -0,0 +1,133 @@
+#pragma once
+
+namespace route_opt {
+    namespace cuda {
+        namespace or_opt {
+            enum MoveType {
+                None = 0,
+                Reversal = 1,          // reverse path[i+1..j]
+                Insertion = 2,         // move path[i..i+length-1] after path[j]
+                ReversedInsertion = 3, // same, with the segment flipped
+            };
+
+            struct Move {
+                double delta;
+                int type;
+                int i;
+                int j;
+                int length;
+            };
+
+            struct MoveLess {
+                __host__ __device__
+                bool operator()(const Move &a, const Move &b) const {
+                    return a.delta < b.delta;
+                }
+            };
+
+            // Cost of edge path[k-1] -> path[k] (or the reverse direction);
+            // inclusive-scanned into prefix sums so that the cost of any
+            // stretch of the tour, walked either way, is a subtraction.
+            struct EdgeCostFunctor {
+                const double *distances;
+                const int *path;
+                const int n;
+                const bool reversed;
+
+                __host__ __device__
+                EdgeCostFunctor(const double *d, const int *p, int size, bool rev) :
+                    distances(d), path(p), n(size), reversed(rev) {
+                }
+
+                __host__ __device__
+                double operator()(int k) const {
+                    if (k == 0) {
+                        return 0.0;
+                    }
+                    return reversed ? distances[path[k] * n + path[k - 1]]
+                                    : distances[path[k - 1] * n + path[k]];
+                }
+            };
+
+            // Best asymmetric-safe move starting at position i. Position 0
+            // stays fixed so that no segment wraps around the array end.
+            struct AsymmetricMoveFunctor {
+                const double *distances;
+                const int *path;
+                const double *forward;
+                const double *backward;
+                const int n;
+                const int max_segment;
+
+                __host__ __device__
+                AsymmetricMoveFunctor(const double *d, const int *p, const double *f,
+                                      const double *b, int size, int segment) :
+                    distances(d), path(p), forward(f), backward(b), n(size), max_segment(segment) {
+                }
+
+                __host__ __device__
+                double dist(int a, int b) const {
+                    return distances[a * n + b];
+                }
+
+                __host__ __device__
+                Move operator()(int i) const {
+                    Move best = {0.0, None, i, 0, 0};
+
+                    // 2-opt: reversing path[i+1..j] changes the cost of the
+                    // reversed stretch from forward to backward prefix sums.
+                    const int a = path[i];
+                    const int b = path[i + 1];
+                    for (int j = i + 2; j < n; ++j) {
+                        const int c = path[j];
+                        const int e = path[(j + 1) % n];
+                        if (e == a) {
+                            continue;
+                        }
+                        const double delta =
+                                dist(a, c) + (backward[j] - backward[i + 1]) + dist(b, e)
+                                - dist(a, b) - (forward[j] - forward[i + 1]) - dist(c, e);
+                        if (delta < best.delta) {
+                            best = {delta, Reversal, i, j, 0};
+                        }
+                    }
+
+                    // Or-opt: move path[i..i+length-1] between path[j] and
+                    // path[j+1], in either orientation.
+                    for (int length = 1; length <= max_segment; ++length) {
+                        const int end = i + length - 1;
+                        if (i == 0 || end >= n - 1 || n - length < 3) {
+                            break;
+                        }
+                        const int first = path[i];
+                        const int last = path[end];
+                        const int x = path[i - 1];
+                        const int y = path[(end + 1) % n];
+                        const double gain = dist(x, first) + dist(last, y) - dist(x, y);
+                        const double flip = (backward[end] - backward[i]) - (forward[end] - forward[i]);
+
+                        for (int j = 0; j < n; ++j) {
+                            if (j >= i - 1 && j <= end) {
+                                continue;
+                            }
+                            const int c = path[j];
+                            const int q = path[(j + 1) % n];
+                            const double base = dist(c, q) + gain;
+
+                            const double keep = dist(c, first) + dist(last, q) - base;
+                            if (keep < best.delta) {
+                                best = {keep, Insertion, i, j, length};
+                            }
+                            const double flipped = dist(c, last) + flip + dist(first, q) - base;
+                            if (flipped < best.delta) {
+                                best = {flipped, ReversedInsertion, i, j, length};
+                            }
+                        }
+                    }
+
+                    return best;
+                }
+            };
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#include "cuda/or_opt.cuh"
 #include <thrust/tuple.h>
 
 namespace route_opt {
@@ -52,6 +53,23 @@ namespace route_opt {
             ~TwoOptOptimizer() override = default;
 
             Route findOptimalRoute(const PointVector &points) override;
+
+            // Symmetric matrices use 2-opt; asymmetric ones switch to moves
+            // that price reversed segments correctly (see or_opt.cuh).
+            Route findOptimalRouteForMatrix(const std::vector<std::vector<double>> &distances) override;
+
+        private:
+            thrust::device_vector<bool> improved_d_;
+            thrust::device_vector<double> forward_d_;
+            thrust::device_vector<double> backward_d_;
+            thrust::device_vector<or_opt::Move> moves_d_;
+
+            void runTwoOpt(const thrust::device_vector<double> &distances_d,
+                           thrust::device_vector<int> &route_d, int n, double lower_bound);
+
+            void runAsymmetric(const thrust::device_vector<double> &distances_d,
+                               thrust::device_vector<int> &route_d, int n,
+                               SolverWorkspace &workspace);
         };
     }
 }
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace route_opt {
+    namespace cuda {
+        // Caching device allocator for thrust's temporary storage (scans,
+        // reductions, min_element). Freed blocks are kept and handed out again
+        // for requests they can hold, so after warm-up thrust algorithms run
+        // without cudaMalloc/cudaFree. Use as thrust::cuda::par(pool).
+        class DevicePool {
+        public:
+            typedef char value_type;
+
+            DevicePool() = default;
+            DevicePool(const DevicePool &) = delete;
+            DevicePool &operator=(const DevicePool &) = delete;
+            ~DevicePool();
+
+            char *allocate(std::ptrdiff_t bytes);
+
+            void deallocate(char *ptr, size_t bytes);
+
+        private:
+            // (pointer, capacity) of blocks that are free / handed out.
+            std::vector<std::pair<char *, size_t>> free_;
+            std::vector<std::pair<char *, size_t>> used_;
+        };
+    }
+}
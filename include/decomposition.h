@@ -0,0 +1,79 @@
+#pragma once
+#include "optimizer.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace route_opt {
+
+struct DecompositionConfig {
+  // Partitions are split until they hold at most this many points.
+  size_t clusterSize = 1000;
+  // Candidate neighbours used by the boundary repair pass.
+  size_t repairNeighbors = 8;
+  // Save the cluster tours solved so far to this file at most every
+  // checkpointInterval seconds, and the stitched tour before the repair
+  // pass; empty disables checkpointing.
+  std::string checkpointPath;
+  double checkpointInterval = 600.0;
+  // Continue from this checkpoint: solved clusters are not solved again and
+  // a stitched tour goes straight to repair. The instance and the settings
+  // above must match the saved run.
+  std::string resumePath;
+};
+
+// Solves very large instances by kd-partitioning the points, optimising each
+// cluster independently in parallel, stitching the sub-tours along a tour of
+// cluster centroids and finally repairing the seams with local search.
+// Memory stays O(n) apart from whatever the per-cluster optimiser needs.
+//
+// Checkpoints copy the partially solved cluster order, so each costs O(n)
+// and is written on a background thread. The repair pass is a single local
+// search descent and is not checkpointed; a run stopped during it repeats
+// the repair. With a deterministic cluster optimiser, as
+// LocalSearchOptimizer is, a resumed run returns the same tour as an
+// uninterrupted one. Instances of at most clusterSize points are solved
+// directly and never checkpointed.
+class DecompositionOptimizer : public RouteOptimizer {
+public:
+  using OptimizerFactory = std::function<RouteOptimizer *()>;
+
+  // An empty factory solves clusters with LocalSearchOptimizer.
+  explicit DecompositionOptimizer(OptimizerFactory factory = nullptr,
+                                  const DecompositionConfig& config = DecompositionConfig{});
+
+  Route findOptimalRoute(const PointVector& points) override;
+
+private:
+  OptimizerFactory factory_;
+  DecompositionConfig config_;
+
+  // Reorders `order` so that every cluster occupies one contiguous range;
+  // returns the range boundaries.
+  std::vector<size_t> partition(const PointVector& points,
+                                std::vector<int>& order) const;
+
+  Route solve(const PointVector& points) const;
+
+  // Solves the clusters not yet marked in `solved`, writing each tour into
+  // its range of `order` and checkpointing as configured.
+  void solveClusters(const PointVector& points, const std::vector<uint64_t>& key,
+                     const std::vector<size_t>& bounds, std::vector<char>& solved,
+                     std::vector<int>& order) const;
+
+  // Joins the cluster tours in `visit` order into one tour.
+  std::vector<int> stitch(const PointVector& points, const PointVector& centroids,
+                          const std::vector<int>& visit, const std::vector<size_t>& bounds,
+                          const std::vector<int>& order) const;
+
+  // Loads config_.resumePath into `solved` and `order`, or into `tour` if it
+  // was saved after stitching.
+  void resume(const std::vector<uint64_t>& key, const std::vector<int>& clusterOf,
+              const std::vector<size_t>& bounds, std::vector<char>& solved,
+              std::vector<int>& order, std::vector<int>& tour) const;
+};
+
+}; // namespace route_opt
@@ -0,0 +1,126 @@
+#pragma once
+#include "metric.h"
+#include "optimizer.h"
+#include "quantized.h"
+#include "types.h"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace route_opt {
+
+struct LocalSearchConfig {
+  size_t candidateNeighbors = 10;
+  // Longest segment moved by Or-opt; 0 restricts the search to 2-opt.
+  size_t maxSegmentLength = 3;
+  // Distance LocalSearchOptimizer uses for point input.
+  MetricKind metric = MetricKind::Euclidean;
+  // Storage the matrix search runs on; totalDistance is always summed from
+  // the caller's doubles. The quantized copy is made next to them, so to
+  // keep only the smaller storage build a QuantizedMatrix directly (row by
+  // row, or with RouteGenerator::generateRoadNetwork) and pass that.
+  DistancePrecision precision = DistancePrecision::Double;
+};
+
+// 2-opt and Or-opt over k-nearest-neighbour candidate lists with don't-look
+// bits. Tours are plain arrays of point indices; reversals always flip the
+// shorter side of the cycle. Candidate rows must be sorted by `Metric`.
+template <typename Metric>
+class LocalSearch {
+  static_assert(Metric::symmetric,
+                "LocalSearch prices reversals as free; use AsymmetricLocalSearch");
+
+public:
+  using value_type = typename Metric::value_type;
+
+  LocalSearch(const Metric& metric, const std::vector<int>& neighbors,
+              size_t k, const LocalSearchConfig& config = LocalSearchConfig{});
+
+  // `neighbors` is a flat n*k candidate array; bookkeeping arrays are
+  // allocated from `memory`.
+  LocalSearch(const Metric& metric, const int* neighbors, size_t k,
+              const LocalSearchConfig& config = LocalSearchConfig{},
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+  // Improves `tour` in place. Only the nodes in `active` start with their
+  // don't-look bit cleared; an empty list activates every node.
+  void improve(std::vector<int>& tour, const std::vector<int>& active = {});
+
+  // Same, for a tour of `n` nodes stored in caller-owned memory.
+  void improve(int* tour, int n, const std::vector<int>& active = {});
+
+private:
+  static constexpr value_type kEpsilon = improvementEpsilon<Metric>();
+
+  Metric metric_;
+  const int* neighbors_;
+  const size_t k_;
+  LocalSearchConfig config_;
+
+  int n_ = 0;
+  int* tour_ = nullptr;
+  std::pmr::vector<int> pos_;
+  std::pmr::vector<int> queue_;
+  std::pmr::vector<char> queued_;
+  size_t head_ = 0;
+
+  value_type dist(int a, int b) const { return metric_(a, b); }
+  int next(int v) const { return tour_[pos_[v] + 1 == n_ ? 0 : pos_[v] + 1]; }
+  int prev(int v) const { return tour_[pos_[v] == 0 ? n_ - 1 : pos_[v] - 1]; }
+
+  void push(int v);
+  bool tryTwoOpt(int a);
+  bool tryOrOpt(int a);
+  void reversePath(int from, int to);
+  void twoOptMove(int a, int b, int c, int d);
+};
+
+extern template class LocalSearch<EuclideanMetric>;
+extern template class LocalSearch<RoundedEuclideanMetric>;
+extern template class LocalSearch<ManhattanMetric>;
+extern template class LocalSearch<GeoMetric>;
+
+// Greedy-matching tour over the k-nearest-neighbour candidate edges.
+std::vector<int> greedyTour(const PointVector& points,
+                            const std::vector<int>& neighbors, size_t k);
+
+// Same under `metric`, written to `tour` (n ints) with scratch taken from
+// `memory`. Instantiated for the coordinate-based metrics.
+template <typename Metric>
+void greedyTour(const Metric& metric, const int* neighbors, size_t k,
+                int* tour, std::pmr::memory_resource* memory);
+
+// Builds a greedy-matching start tour and runs LocalSearch on the CPU. The
+// metric is chosen once per solve from the config; everything below that
+// point is compiled for it. Matrix input goes through AsymmetricLocalSearch,
+// which is safe for both symmetric and asymmetric distances.
+class LocalSearchOptimizer : public RouteOptimizer {
+public:
+  explicit LocalSearchOptimizer(const LocalSearchConfig& config = LocalSearchConfig{});
+
+  Route findOptimalRoute(const PointVector& points) override;
+
+  Route findOptimalRouteForMatrix(const std::vector<std::vector<double>>& distances) override;
+
+  // For callers that keep only the quantized matrix; totalDistance is the
+  // sum of the dequantized entries.
+  Route findOptimalRouteForMatrix(const QuantizedMatrix& distances);
+
+private:
+  LocalSearchConfig config_;
+
+  template <typename Metric>
+  Route solve(const Metric& metric);
+
+  template <typename Metric>
+  std::vector<int> solveMatrix(const Metric& metric);
+};
+
+namespace utils {
+double tourLength(const PointVector& points, const std::vector<int>& tour);
+
+double tourLength(const std::vector<std::vector<double>>& distances,
+                  const std::vector<int>& tour);
+}; // namespace utils
+
+}; // namespace route_opt
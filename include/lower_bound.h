@@ -0,0 +1,69 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <vector>
+
+namespace route_opt {
+
+struct LowerBoundConfig {
+  // Candidate edges per node used during subgradient optimisation.
+  size_t candidateNeighbors = 10;
+  size_t maxIterations = 200;
+
+  // Polyak step multiplier; halved after stallIterations without progress.
+  double initialStep = 2.0;
+  size_t stallIterations = 20;
+
+  // Stop once (upperBound - bound) / bound drops below this value.
+  double targetGap = 0.0;
+
+  // Instances up to this size get a final 1-tree over the complete graph,
+  // which turns the sparse estimate into a certified lower bound.
+  size_t certifyLimit = 20000;
+};
+
+struct LowerBoundResult {
+  double bound = 0.0;
+  bool certified = false;
+  size_t iterations = 0;
+  std::vector<double> penalties;
+};
+
+// Held-Karp lower bound: minimum 1-trees with subgradient-optimised node
+// penalties, restricted to k-nearest-neighbour candidate edges.
+class HeldKarpBound {
+public:
+  explicit HeldKarpBound(const LowerBoundConfig& config = LowerBoundConfig{});
+
+  // upperBound is the length of any known tour and drives the step size;
+  // when it is 0 an estimate 10% above the first 1-tree is used.
+  LowerBoundResult compute(const PointVector& points,
+                           double upperBound = 0.0) const;
+
+private:
+  LowerBoundConfig config_;
+
+  struct Edge {
+    int from, to;
+    double length;
+  };
+
+  std::vector<Edge> candidateEdges(const PointVector& points) const;
+
+  double sparseOneTree(const std::vector<Edge>& edges, size_t n,
+                       const std::vector<double>& penalties,
+                       std::vector<int>& degrees) const;
+
+  double denseOneTree(const PointVector& points,
+                      const std::vector<double>& penalties) const;
+};
+
+// HeldKarpBound().compute(points).bound if it is certified, else 0. An
+// estimate may lie above the optimum, so only this can justify stopping a
+// search at a gap tolerance.
+double certifiedLowerBound(const PointVector& points);
+
+// Relative distance of a tour from a lower bound, e.g. 0.02 for 2%.
+double optimalityGap(double tourLength, double lowerBound);
+
+}; // namespace route_opt
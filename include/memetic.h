@@ -0,0 +1,54 @@
+#pragma once
+#include "optimizer.h"
+#include "types.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace route_opt {
+
+struct MemeticConfig {
+  // 0 runs one island per OpenMP thread.
+  size_t islands = 0;
+  size_t populationSize = 16;
+  // Generations each island runs between two migrations.
+  size_t migrationInterval = 50;
+  // Wall-clock budget in seconds.
+  double timeLimit = 60.0;
+  // Stop after this many migrations without a new best tour; 0 disables.
+  size_t stallMigrations = 0;
+  size_t candidateNeighbors = 10;
+  unsigned int seed = 42;
+  // Snapshot the search to this file at most every checkpointInterval
+  // seconds; empty disables checkpointing.
+  std::string checkpointPath;
+  double checkpointInterval = 600.0;
+  // Continue the search saved in this checkpoint instead of starting a new
+  // one. The instance and the settings above must match the saved run, and
+  // the time already spent counts against timeLimit.
+  std::string resumePath;
+};
+
+// Island-model memetic algorithm. Every island evolves its own population
+// with edge-recombination crossover followed by local-search polishing of
+// the child, and the islands pass their best tour around a ring at every
+// migration. All tours live in one flat arena of n-int rows per island.
+//
+// Checkpoints are taken between migrations on a background thread. They
+// hold the populations, every island's RNG state and the counters, so a
+// resumed run repeats the generations the interrupted one would have run.
+// Local search converges within each generation, so no don't-look bits are
+// pending at that point. The snapshot references the population rows
+// instead of copying them; until it is written, replaced members go to
+// spare rows, which doubles the arena while checkpointing is enabled.
+class MemeticOptimizer : public RouteOptimizer {
+public:
+  explicit MemeticOptimizer(const MemeticConfig& config = MemeticConfig{});
+
+  Route findOptimalRoute(const PointVector& points) override;
+
+private:
+  MemeticConfig config_;
+};
+
+}; // namespace route_opt
@@ -0,0 +1,172 @@
+#pragma once
+#include "types.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace route_opt {
+
+enum class MetricKind {
+  Euclidean,
+  RoundedEuclidean,  // TSPLIB EUC_2D
+  Manhattan,
+  Geographic,
+  Matrix,
+};
+
+// Distance policies for the templated optimizer cores. Each policy is a
+// cheap, copyable view over the caller's data with operator()(a, b)
+// returning a value_type, plus compile-time traits:
+//   symmetric       - d(a, b) == d(b, a) is guaranteed
+//   coordinateBased - distances derive from point coordinates, so
+//                     SpatialGrid candidate lists and Hilbert order apply
+//   integral        - value_type is an integer, so deltas compare exactly
+//   euclideanOrder  - sorting by Euclidean distance also sorts by this
+//                     metric, so SpatialGrid rows need no re-sorting
+
+struct EuclideanMetric {
+  using value_type = double;
+  static constexpr MetricKind kind = MetricKind::Euclidean;
+  static constexpr bool symmetric = true;
+  static constexpr bool coordinateBased = true;
+  static constexpr bool integral = false;
+  static constexpr bool euclideanOrder = true;
+
+  explicit EuclideanMetric(const PointVector& points) : points_(&points) {}
+
+  value_type operator()(int a, int b) const {
+    const double dx = (*points_)[a].x - (*points_)[b].x;
+    const double dy = (*points_)[a].y - (*points_)[b].y;
+    return std::sqrt(dx * dx + dy * dy);
+  }
+
+  size_t size() const { return points_->size(); }
+  const PointVector& points() const { return *points_; }
+
+private:
+  const PointVector* points_;
+};
+
+// nint(sqrt(dx^2 + dy^2)) as in TSPLIB EUC_2D instances.
+struct RoundedEuclideanMetric {
+  using value_type = int;
+  static constexpr MetricKind kind = MetricKind::RoundedEuclidean;
+  static constexpr bool symmetric = true;
+  static constexpr bool coordinateBased = true;
+  static constexpr bool integral = true;
+  static constexpr bool euclideanOrder = true;
+
+  explicit RoundedEuclideanMetric(const PointVector& points) : points_(&points) {}
+
+  value_type operator()(int a, int b) const {
+    const double dx = (*points_)[a].x - (*points_)[b].x;
+    const double dy = (*points_)[a].y - (*points_)[b].y;
+    return static_cast<int>(std::sqrt(dx * dx + dy * dy) + 0.5);
+  }
+
+  size_t size() const { return points_->size(); }
+  const PointVector& points() const { return *points_; }
+
+private:
+  const PointVector* points_;
+};
+
+struct ManhattanMetric {
+  using value_type = double;
+  static constexpr MetricKind kind = MetricKind::Manhattan;
+  static constexpr bool symmetric = true;
+  static constexpr bool coordinateBased = true;
+  static constexpr bool integral = false;
+  static constexpr bool euclideanOrder = false;
+
+  explicit ManhattanMetric(const PointVector& points) : points_(&points) {}
+
+  value_type operator()(int a, int b) const {
+    return std::abs((*points_)[a].x - (*points_)[b].x) +
+           std::abs((*points_)[a].y - (*points_)[b].y);
+  }
+
+  size_t size() const { return points_->size(); }
+  const PointVector& points() const { return *points_; }
+
+private:
+  const PointVector* points_;
+};
+
+// Great-circle distance in kilometres; Point::x is the latitude and Point::y
+// the longitude, both in degrees.
+struct GeoMetric {
+  using value_type = double;
+  static constexpr MetricKind kind = MetricKind::Geographic;
+  static constexpr bool symmetric = true;
+  static constexpr bool coordinateBased = true;
+  static constexpr bool integral = false;
+  static constexpr bool euclideanOrder = false;
+
+  static constexpr double kEarthRadius = 6371.0088;
+  static constexpr double kRadians = 3.14159265358979323846 / 180.0;
+
+  explicit GeoMetric(const PointVector& points) : points_(&points) {}
+
+  value_type operator()(int a, int b) const {
+    const Point& p = (*points_)[a];
+    const Point& q = (*points_)[b];
+    const double sinLat = std::sin((q.x - p.x) * kRadians / 2);
+    const double sinLon = std::sin((q.y - p.y) * kRadians / 2);
+    const double h = sinLat * sinLat +
+                     std::cos(p.x * kRadians) * std::cos(q.x * kRadians) * sinLon * sinLon;
+    return 2 * kEarthRadius * std::asin(std::sqrt(std::min(h, 1.0)));
+  }
+
+  size_t size() const { return points_->size(); }
+  const PointVector& points() const { return *points_; }
+
+private:
+  const PointVector* points_;
+};
+
+// Explicit, possibly asymmetric, distance matrix.
+struct MatrixMetric {
+  using value_type = double;
+  static constexpr MetricKind kind = MetricKind::Matrix;
+  static constexpr bool symmetric = false;
+  static constexpr bool coordinateBased = false;
+  static constexpr bool integral = false;
+  static constexpr bool euclideanOrder = false;
+
+  explicit MatrixMetric(const std::vector<std::vector<double>>& distances)
+      : rows_(distances.data()), n_(distances.size()) {}
+
+  value_type operator()(int a, int b) const { return rows_[a][b]; }
+
+  size_t size() const { return n_; }
+
+private:
+  const std::vector<double>* rows_;
+  size_t n_;
+};
+
+// Smallest delta that counts as an improvement: zero for integer metrics,
+// a rounding guard otherwise.
+template <typename Metric>
+constexpr typename Metric::value_type improvementEpsilon() {
+  if constexpr (Metric::integral) {
+    return 0;
+  } else {
+    return 1e-10;
+  }
+}
+
+namespace utils {
+template <typename Metric>
+double tourLength(const Metric& metric, const std::vector<int>& tour) {
+  double total = 0.0;
+  for (size_t i = 0; i < tour.size(); ++i) {
+    total += metric(tour[i], tour[i + 1 == tour.size() ? 0 : i + 1]);
+  }
+  return total;
+}
+}; // namespace utils
+
+}; // namespace route_opt
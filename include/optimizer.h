@@ -1,5 +1,8 @@
 #pragma once
 #include "types.h"
+#include "workspace.h"
+#include <stdexcept>
+#include <vector>
 
 namespace route_opt {
   class RouteOptimizer {
@@ -8,6 +11,40 @@ namespace route_opt {
 
     virtual Route findOptimalRoute(const PointVector &points) = 0;
 
+    // Optimises over an explicit, possibly asymmetric, distance matrix such
+    // as RouteGenerator::generateRoadNetwork output.
+    virtual Route findOptimalRouteForMatrix(const std::vector<std::vector<double>> &distances) {
+      (void)distances;
+      throw std::logic_error("Optimizer requires point coordinates");
+    }
+
     static RouteOptimizer *createOptimizer(bool useGPU = false);
+
+    // Stop as soon as the tour is within `tolerance` (relative) of the
+    // Held-Karp lower bound, e.g. 0.01 for 1%. Zero disables the check.
+    // Only optimizers that keep improving until a budget runs out honour it
+    // (cuda::TwoOptOptimizer and MemeticOptimizer); single-descent ones such
+    // as LocalSearchOptimizer and DecompositionOptimizer ignore it. Bounds
+    // that are not certified (see HeldKarpBound) never stop a search early.
+    void setGapTolerance(double tolerance) { gapTolerance_ = tolerance; }
+
+    // Draw scratch memory from `workspace` instead of the optimizer's own, e.g.
+    // to share one workspace across the optimizers of a RouteManager. Null
+    // restores the private one.
+    void setWorkspace(SolverWorkspace *workspace) { workspace_ = workspace; }
+
+  protected:
+    double gapTolerance_ = 0.0;
+
+    // Resets and returns the active workspace; call once per solve.
+    SolverWorkspace &beginSolve() {
+      SolverWorkspace &workspace = workspace_ ? *workspace_ : ownWorkspace_;
+      workspace.reset();
+      return workspace;
+    }
+
+  private:
+    SolverWorkspace ownWorkspace_;
+    SolverWorkspace *workspace_ = nullptr;
   };
 }; // namespace route_opt
@@ -0,0 +1,105 @@
+#pragma once
+#include "metric.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace route_opt {
+
+enum class DistancePrecision {
+  Double,
+  Int32,   // 4 bytes per entry
+  UInt16,  // 2 bytes per entry plus one shift per row
+};
+
+// Distance matrix rounded to integer multiples of a quantum. Int32 stores
+// every entry to within quantum / 2. UInt16 stores a 16-bit mantissa per
+// entry and a power-of-two exponent per row, so entry (a, b) is
+// mantissa << shift[a] quanta and rows with long distances keep fewer low
+// bits. Both read back as exact integers in quanta, which lets optimizers
+// compare move deltas without rounding error. The CUDA optimizers do not
+// read this storage; they still upload doubles.
+class QuantizedMatrix {
+public:
+  // A zero quantum maps the largest entry to 2^30 quanta.
+  QuantizedMatrix(const std::vector<std::vector<double>>& distances,
+                  DistancePrecision precision, double quantum = 0.0);
+
+  // An n x n matrix of zeros to be filled with setRow(), so that no full
+  // matrix of doubles has to exist. The quantum must be positive since no
+  // entry is known yet; entries may reach 2^30 quanta.
+  QuantizedMatrix(size_t n, DistancePrecision precision, double quantum);
+
+  // Quantizes the n distances from node a. Distinct rows may be set from
+  // different threads at the same time.
+  void setRow(size_t a, const double* distances);
+
+  size_t size() const { return n_; }
+  double quantum() const { return quantum_; }
+  DistancePrecision precision() const { return precision_; }
+
+  // Bytes held by the quantized entries.
+  size_t bytes() const;
+
+  // Entry (a, b) in quanta, and converted back to a distance.
+  int64_t quanta(int a, int b) const;
+  double distance(int a, int b) const { return quanta(a, b) * quantum_; }
+
+private:
+  friend struct Int32MatrixMetric;
+  friend struct UInt16MatrixMetric;
+
+  size_t n_;
+  DistancePrecision precision_;
+  double quantum_;
+  std::vector<int32_t> wide_;
+  std::vector<uint16_t> narrow_;
+  std::vector<uint8_t> shift_;
+
+  void allocate();
+};
+
+// Metric policies over QuantizedMatrix storage (see metric.h for the traits).
+// The matrix must outlive the metric and have the matching precision.
+struct Int32MatrixMetric {
+  using value_type = int64_t;
+  static constexpr MetricKind kind = MetricKind::Matrix;
+  static constexpr bool symmetric = false;
+  static constexpr bool coordinateBased = false;
+  static constexpr bool integral = true;
+  static constexpr bool euclideanOrder = false;
+
+  explicit Int32MatrixMetric(const QuantizedMatrix& matrix);
+
+  value_type operator()(int a, int b) const { return values_[a * n_ + b]; }
+
+  size_t size() const { return n_; }
+
+private:
+  const int32_t* values_;
+  size_t n_;
+};
+
+struct UInt16MatrixMetric {
+  using value_type = int64_t;
+  static constexpr MetricKind kind = MetricKind::Matrix;
+  static constexpr bool symmetric = false;
+  static constexpr bool coordinateBased = false;
+  static constexpr bool integral = true;
+  static constexpr bool euclideanOrder = false;
+
+  explicit UInt16MatrixMetric(const QuantizedMatrix& matrix);
+
+  value_type operator()(int a, int b) const {
+    return static_cast<value_type>(values_[a * n_ + b]) << shift_[a];
+  }
+
+  size_t size() const { return n_; }
+
+private:
+  const uint16_t* values_;
+  const uint8_t* shift_;
+  size_t n_;
+};
+
+}; // namespace route_opt
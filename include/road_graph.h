@@ -0,0 +1,47 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace route_opt {
+
+// Directed road graph in CSR layout: the arcs leaving node v are
+// [offsets()[v], offsets()[v + 1]) in targets() and weights(). Weights are
+// travel times, or any other non-negative arc cost. Every node has
+// coordinates, which are used to snap stops onto the graph.
+class RoadGraph {
+public:
+  struct Arc {
+    int from;
+    int to;
+    double weight;
+  };
+
+  RoadGraph() = default;
+  RoadGraph(PointVector coordinates, const std::vector<Arc>& arcs);
+
+  size_t nodeCount() const { return coordinates_.size(); }
+  size_t arcCount() const { return targets_.size(); }
+
+  const PointVector& coordinates() const { return coordinates_; }
+  const std::vector<int>& offsets() const { return offsets_; }
+  const std::vector<int>& targets() const { return targets_; }
+  const std::vector<double>& weights() const { return weights_; }
+
+  // Node closest in the plane to each stop.
+  std::vector<int> nearestNodes(const PointVector& stops) const;
+
+  // Graph in the 9th DIMACS shortest-path challenge format: "a <from> <to>
+  // <weight>" lines in `graphFile`, "v <id> <x> <y>" lines in
+  // `coordinateFile`, 1-based ids, "c" comment lines and "p" header lines.
+  static RoadGraph loadDimacs(const std::string& graphFile, const std::string& coordinateFile);
+
+private:
+  PointVector coordinates_;
+  std::vector<int> offsets_{0};
+  std::vector<int> targets_;
+  std::vector<double> weights_;
+};
+
+}; // namespace route_opt
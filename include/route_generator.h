@@ -1,4 +1,6 @@
 #pragma once
+#include "quantized.h"
+#include "road_graph.h"
 #include "types.h"
 #include <random>
 #include <string>
@@ -17,6 +19,9 @@ struct GeneratorConfig {
 
   size_t numTimeSlots = 24;
   double peakHourFactor = 2.0;
+
+  double minDemand = 1.0;
+  double maxDemand = 10.0;
 };
 
 class RouteGenerator {
@@ -26,6 +31,10 @@ public:
   std::vector<std::vector<double>>
   generateEuclidean(const PointVector& points) const;
 
+  // Row-major n*n matrix written to caller-owned storage, without the n+1
+  // allocations of the nested form.
+  void generateEuclidean(const PointVector& points, double* distances) const;
+
   std::pair<PointVector, std::vector<std::vector<double>>>
   generateRandomEuclidean(const GeneratorConfig& config = GeneratorConfig{});
 
@@ -33,11 +42,36 @@ public:
   generateRoadNetwork(const PointVector& points, double trafficFactor = 0.3,
                       double oneWayProbabilty = 0.2);
 
+  // Travel times between `stops` over a road graph, each stop snapped to its
+  // nearest node; builds a ContractionHierarchy for the many-to-many query.
+  // Keep a ContractionHierarchy instead when several matrices are needed
+  // from one graph. Throws std::runtime_error naming the stops involved if
+  // any stop cannot reach another.
+  std::vector<std::vector<double>>
+  generateRoadNetwork(const RoadGraph& graph, const PointVector& stops) const;
+
+  // Same, stored at `precision` (see QuantizedMatrix) without ever holding
+  // the matrix as doubles. Also throws if a pair is unreachable.
+  QuantizedMatrix generateRoadNetwork(const RoadGraph& graph, const PointVector& stops,
+                                      DistancePrecision precision, double quantum) const;
+
+  // Synthetic city of about numPoints intersections on a jittered grid.
+  // Every eighth street is a faster arterial; other inner streets are
+  // one-way with probability oneWayProbability, alternating direction like
+  // a street grid. Arterials and the ring road stay two-way, which keeps the
+  // graph strongly connected. Weights are travel times: length / speed,
+  // scaled by up to 1 + trafficFactor per arc.
+  RoadGraph generateRoadGraph(const GeneratorConfig& config = GeneratorConfig{});
+
   std::vector<std::vector<std::vector<double>>> generateTimeDependent(
         const PointVector& points,
         const GeneratorConfig& config = GeneratorConfig{}
     );
 
+  // Integral per-stop demands in [minDemand, maxDemand]; entry `depot` is 0.
+  std::vector<double> generateDemands(size_t numPoints, size_t depot = 0,
+                                      const GeneratorConfig& config = GeneratorConfig{});
+
   void saveToFile(const std::vector<std::vector<double>>& distances,
                   const std::string& filename) const;
 
@@ -68,6 +102,7 @@ namespace utils {
 std::vector<std::vector<double>>
 convertToMatrix(const std::vector<double>& flatMatrix, size_t size);
 
+// Square, zero diagonal, every entry finite and non-negative.
 bool isValidDistanceMatrix(const std::vector<std::vector<double>>& distances);
 
 bool isSymmetric(const std::vector<std::vector<double>>& distances);
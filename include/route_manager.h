@@ -1,9 +1,13 @@
 #pragma once
 #include "optimizer.h"
 #include "types.h"
+#include "workspace.h"
 #include <memory>
 
 namespace route_opt {
+// Runs repeated solves through one optimizer. Scratch memory comes from a
+// workspace owned by the manager, so solves after the first allocate only
+// the returned route.
 class RouteManager {
 public:
   explicit RouteManager(bool useGPU = false);
@@ -12,6 +16,8 @@ public:
 
 private:
   PointVector points_;
+  // Declared before the optimizer, which keeps a pointer to it.
+  SolverWorkspace workspace_;
   std::unique_ptr<RouteOptimizer> optimizer_;
 };
 
@@ -0,0 +1,60 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace route_opt {
+
+// Uniform bucket grid over the bounding box of a point set. Used to build
+// candidate neighbour lists without evaluating all O(n^2) pairs.
+class SpatialGrid {
+public:
+  // Internal buffers come from `memory`, e.g. SolverWorkspace::resource().
+  explicit SpatialGrid(const PointVector& points, size_t pointsPerCell = 2,
+                       std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+  // Flat n*k array: row i holds the k nearest neighbours of point i, closest
+  // first. Rows are padded with -1 when the set has fewer than k+1 points.
+  std::vector<int> nearestNeighbors(size_t k) const;
+
+  // Same, written to caller-owned storage of n*k ints.
+  void nearestNeighbors(size_t k, int* neighbors) const;
+
+  // Index of the point closest to `query`, which need not be in the set;
+  // -1 for an empty set.
+  int nearest(const Point& query) const;
+
+  // Nearest point closer than maxDistance whose label is neither `exclude`
+  // nor negative, with labels[i] the label of point i; -1 if there is none.
+  int nearestOutside(const Point& query, const int* labels, int exclude,
+                     double maxDistance) const;
+
+private:
+  const PointVector& points_;
+  std::pmr::memory_resource* memory_;
+  double minX_ = 0.0;
+  double minY_ = 0.0;
+  double cellSize_ = 1.0;
+  long cols_ = 1;
+  long rows_ = 1;
+
+  // Bucket contents in CSR form: points of cell c are
+  // cellPoints_[cellStart_[c] .. cellStart_[c + 1]).
+  std::pmr::vector<int> cellStart_;
+  std::pmr::vector<int> cellPoints_;
+
+  long cellX(double x) const;
+  long cellY(double y) const;
+};
+
+// Point indices ordered along a Hilbert curve over the bounding box. Nearby
+// positions in the order are nearby in the plane, which makes it a cheap
+// O(n log n) start tour and a locality-preserving partition order.
+std::vector<int> hilbertOrder(const PointVector& points);
+
+// Same, written to `order` (n ints) with scratch taken from `memory`.
+void hilbertOrder(const PointVector& points, int* order,
+                  std::pmr::memory_resource* memory);
+
+}; // namespace route_opt
@@ -0,0 +1,71 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace route_opt {
+
+struct TimeWindow {
+  double earliest = 0.0;
+  double latest = std::numeric_limits<double>::infinity();
+  double serviceTime = 0.0;
+};
+
+// A single vehicle leaving the depot at departureTime, visiting every stop
+// within its window and returning. Travel times come from
+// RouteGenerator::generateTimeDependent: travelTimes[slot][from][to], with
+// slot = floor(t / slotLength) wrapping around the number of slots.
+struct TimeWindowProblem {
+  std::vector<std::vector<std::vector<double>>> travelTimes;
+  std::vector<TimeWindow> windows;
+  double slotLength = 60.0;
+  double departureTime = 0.0;
+  int depot = 0;
+};
+
+struct TimeWindowConfig {
+  size_t maxMoves = 100000;
+  // Moves only make a stop adjacent to one of this many correlated stops.
+  size_t candidateNeighbors = 20;
+  // Longest segment moved by Or-opt.
+  size_t maxSegmentLength = 3;
+};
+
+// Service start times follow the time-warp convention: arriving after a
+// window closes is recorded as lateness and the clock is set back to the
+// window end, so timeWarp is the total lateness and is 0 for a feasible route.
+struct ScheduledRoute {
+  Route route;  // starts at the depot; totalDistance is the total travel time
+  std::vector<double> startTimes;  // one per route.path entry
+  double returnTime = 0.0;
+  double timeWarp = 0.0;
+
+  bool feasible() const { return timeWarp <= 1e-9; }
+};
+
+// Minimises total time-dependent travel time subject to time windows with
+// 2-opt and Or-opt restricted to candidate neighbours and driven by a work
+// queue. Moves are screened in O(log n) by concatenating segment summaries
+// (duration, time warp, earliest and latest start) of forward and reversed
+// runs, each entered at the time the new route reaches it. Screened moves
+// are confirmed exactly from the point they change, walking only stretches
+// whose departures would move into another time slot; accepted moves pay
+// for an O(n log n) rebuild from that point. With several slots the search
+// starts from a tour optimised on the mean travel times. Up to 8 stops every
+// order is tried instead.
+class TimeWindowOptimizer {
+public:
+  explicit TimeWindowOptimizer(const TimeWindowConfig& config = TimeWindowConfig{});
+
+  ScheduledRoute solve(const TimeWindowProblem& problem) const;
+
+  // Exact schedule of `path`, which must start at the depot.
+  ScheduledRoute evaluate(const TimeWindowProblem& problem,
+                          const std::vector<int>& path) const;
+
+private:
+  TimeWindowConfig config_;
+};
+
+}; // namespace route_opt
@@ -0,0 +1,55 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <vector>
+
+namespace route_opt {
+
+// Capacitated vehicle routing: every vehicle leaves the depot, serves a
+// subset of stops without exceeding its capacity and returns. Instances can
+// be synthesised with RouteGenerator::generateRandomEuclidean and
+// RouteGenerator::generateDemands.
+struct VehicleRoutingProblem {
+  PointVector points;
+  std::vector<double> demands;  // one per point; the depot entry is ignored
+  double vehicleCapacity = 100.0;
+  // Size of the fleet; 0 puts no limit on the number of routes.
+  size_t vehicles = 0;
+  int depot = 0;
+};
+
+struct CVRPConfig {
+  // Independent savings + local search runs, spread over the CPU cores.
+  // 0 uses one run per hardware thread.
+  size_t starts = 0;
+  size_t candidateNeighbors = 20;
+  unsigned seed = 42;
+};
+
+// One Route per vehicle. Each path starts at the depot and is closed like
+// any other Route, so totalDistance includes the legs to and from the depot.
+struct FleetSolution {
+  std::vector<Route> routes;
+  double totalDistance = 0.0;
+};
+
+// Clarke-Wright savings construction followed by relocate, swap, 2-opt and
+// 2-opt* local search with O(1) delta and capacity evaluation. With a
+// limited fleet, construction empties the lightest routes into the others
+// until the routes fit the fleet; local search never opens a route. solve()
+// throws std::runtime_error if no start manages to fit the fleet.
+class CVRPSolver {
+public:
+  explicit CVRPSolver(const CVRPConfig& config = CVRPConfig{});
+
+  FleetSolution solve(const VehicleRoutingProblem& problem) const;
+
+private:
+  CVRPConfig config_;
+
+  std::vector<std::vector<int>> savings(const VehicleRoutingProblem& problem,
+                                        const std::vector<int>& neighbors,
+                                        size_t k, double shape) const;
+};
+
+}; // namespace route_opt
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace route_opt {
+
+// Bump-pointer arena for per-solve scratch memory. Unlike
+// std::pmr::monotonic_buffer_resource, reset() keeps the memory: the blocks
+// used since the last reset are merged into one block large enough for all
+// of them, so once a problem size has been seen, later solves of that size
+// take nothing from the heap. Deallocation is a no-op. Not thread-safe.
+class Arena : public std::pmr::memory_resource {
+public:
+  explicit Arena(size_t initialSize = 64 * 1024);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Releases every allocation at once.
+  void reset();
+
+  // Bytes currently owned by the arena.
+  size_t capacity() const;
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  size_t initialSize_;
+  std::vector<Block> blocks_;
+  size_t current_ = 0;
+  size_t offset_ = 0;
+
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void*, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Scratch memory for solves. Optimizers reset it when a solve starts, so it
+// can be shared between consecutive solves (RouteManager does) but never by
+// two solves running at the same time.
+class SolverWorkspace {
+public:
+  explicit SolverWorkspace(size_t initialSize = 64 * 1024) : arena_(initialSize) {}
+
+  // For std::pmr containers that should live in the workspace.
+  std::pmr::memory_resource* resource() { return &arena_; }
+
+  // Uninitialised storage for `count` objects of a trivial type.
+  template <typename T>
+  T* allocate(size_t count) {
+    static_assert(std::is_trivially_default_constructible_v<T> &&
+                      std::is_trivially_destructible_v<T>,
+                  "SolverWorkspace::allocate requires a trivial type");
+    return static_cast<T*>(arena_.allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void reset() { arena_.reset(); }
+
+  size_t capacity() const { return arena_.capacity(); }
+
+private:
+  Arena arena_;
+};
+
+}; // namespace route_opt
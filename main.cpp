@@ -1,4 +1,5 @@
 #include "cuda/optimizer.cuh"
+#include "lower_bound.h"
 #include "route_generator.h"
 #include "visualizer.h"
 #include <iostream>
@@ -139,6 +140,14 @@ int main() {
             std::cout << "\nWarning: Invalid initial distance\n";
         }
 
+        // Distance from optimal, measured against the Held-Karp bound
+        route_opt::LowerBoundResult bound =
+                route_opt::HeldKarpBound().compute(points, optimized_route.totalDistance);
+        std::cout << "Lower bound: " << std::fixed << std::setprecision(2) << bound.bound
+                << (bound.certified ? "" : " (estimate)") << "\n";
+        std::cout << "Optimality gap: " << std::fixed << std::setprecision(2)
+                << route_opt::optimalityGap(optimized_route.totalDistance, bound.bound) * 100.0 << "%\n";
+
         visualizer.finalizeVideo();
         delete optimizer;
 
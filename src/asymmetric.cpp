@@ -0,0 +1,211 @@
+#include "asymmetric.h"
+#include <omp.h>
+#include <algorithm>
+#include <numeric>
+
+namespace route_opt {
+
+template <typename Metric>
+AsymmetricLocalSearch<Metric>::AsymmetricLocalSearch(const Metric& metric, size_t k,
+                                                     size_t maxSegmentLength,
+                                                     std::pmr::memory_resource* memory)
+    : metric_(metric),
+      n_(static_cast<int>(metric.size())),
+      k_(std::min<size_t>(k, n_ == 0 ? 0 : n_ - 1)),
+      maxSegmentLength_(maxSegmentLength),
+      outNeighbors_(n_ * k_, memory),
+      inNeighbors_(n_ * k_, memory),
+      tour_(memory),
+      pos_(memory),
+      forward_(memory),
+      backward_(memory),
+      segment_(memory),
+      next_(memory) {
+  if (n_ < 2) return;
+
+  // One row of other nodes per thread, taken from `memory` up front since
+  // a workspace arena is not thread-safe.
+  const int threads = omp_get_max_threads();
+  std::pmr::vector<int> scratch(size_t(threads) * (n_ - 1), memory);
+
+#pragma omp parallel for num_threads(threads)
+  for (int v = 0; v < n_; ++v) {
+    int* others = scratch.data() + size_t(omp_get_thread_num()) * (n_ - 1);
+    int* end = others;
+    for (int w = 0; w < n_; ++w) {
+      if (w != v) *end++ = w;
+    }
+
+    std::partial_sort(others, others + k_, end,
+                      [&](int a, int b) { return dist(v, a) < dist(v, b); });
+    std::copy(others, others + k_, outNeighbors_.begin() + v * k_);
+
+    std::partial_sort(others, others + k_, end,
+                      [&](int a, int b) { return dist(a, v) < dist(b, v); });
+    std::copy(others, others + k_, inNeighbors_.begin() + v * k_);
+  }
+}
+
+template <typename Metric>
+std::vector<int> AsymmetricLocalSearch<Metric>::nearestNeighborTour() const {
+  std::vector<int> tour;
+  tour.reserve(n_);
+  std::pmr::vector<char> visited(n_, 0, tour_.get_allocator().resource());
+  int current = 0;
+  for (int step = 0; step < n_; ++step) {
+    tour.push_back(current);
+    visited[current] = 1;
+    int next = -1;
+    for (int w = 0; w < n_; ++w) {
+      if (!visited[w] && (next < 0 || dist(current, w) < dist(current, next))) next = w;
+    }
+    current = next;
+  }
+  return tour;
+}
+
+template <typename Metric>
+void AsymmetricLocalSearch<Metric>::refresh() {
+  pos_.resize(n_);
+  forward_.resize(n_);
+  backward_.resize(n_);
+  forward_[0] = backward_[0] = 0.0;
+  pos_[tour_[0]] = 0;
+  for (int i = 1; i < n_; ++i) {
+    pos_[tour_[i]] = i;
+    forward_[i] = forward_[i - 1] + dist(tour_[i - 1], tour_[i]);
+    backward_[i] = backward_[i - 1] + dist(tour_[i], tour_[i - 1]);
+  }
+}
+
+// Cost of walking the tour forward from position `from` to position `to`.
+template <typename Metric>
+double AsymmetricLocalSearch<Metric>::forwardCost(int from, int to) const {
+  if (from <= to) return forward_[to] - forward_[from];
+  return forward_[n_ - 1] - forward_[from] + dist(tour_[n_ - 1], tour_[0]) + forward_[to];
+}
+
+// Cost of walking the same positions in the opposite direction.
+template <typename Metric>
+double AsymmetricLocalSearch<Metric>::backwardCost(int from, int to) const {
+  if (from <= to) return backward_[to] - backward_[from];
+  return backward_[n_ - 1] - backward_[from] + dist(tour_[0], tour_[n_ - 1]) + backward_[to];
+}
+
+// Reverses positions i+1..j so that the tour continues a -> c.
+template <typename Metric>
+bool AsymmetricLocalSearch<Metric>::tryTwoOpt(int i) {
+  const int a = at(i), b = at(i + 1);
+  const value_type ab = dist(a, b);
+  const int* candidates = &outNeighbors_[a * k_];
+
+  for (size_t t = 0; t < k_; ++t) {
+    const int c = candidates[t];
+    const value_type ac = dist(a, c);
+    if (ac >= ab - kEpsilon) break;
+
+    const int j = pos_[c];
+    const int e = at(j + 1);
+    if (c == b || e == a) continue;
+
+    const int first = (i + 1) % n_;
+    const double delta = ac + backwardCost(first, j) + dist(b, e)
+                       - ab - forwardCost(first, j) - dist(c, e);
+    if (!(delta < -kEpsilon)) continue;
+
+    int lo = first, hi = j;
+    for (int s = ((j - first + n_) % n_ + 1) / 2; s > 0; --s) {
+      std::swap(tour_[lo], tour_[hi]);
+      lo = lo + 1 == n_ ? 0 : lo + 1;
+      hi = hi == 0 ? n_ - 1 : hi - 1;
+    }
+    refresh();
+    return true;
+  }
+  return false;
+}
+
+// Moves the segment starting at position s between another pair of
+// consecutive nodes, keeping or flipping its orientation.
+template <typename Metric>
+bool AsymmetricLocalSearch<Metric>::tryOrOpt(int s) {
+  const int maxLength = std::min<int>(maxSegmentLength_, n_ - 3);
+
+  for (int length = 1; length <= maxLength; ++length) {
+    const int e = (s + length - 1) % n_;
+    const int first = at(s), last = at(e);
+    const int x = at(s - 1), y = at(e + 1);
+    const double gain = dist(x, first) + dist(last, y) - dist(x, y);
+    if (!(gain > kEpsilon)) continue;
+
+    auto inSegment = [&](int v) { return (pos_[v] - s + n_) % n_ < length; };
+    const double flip = backwardCost(s, e) - forwardCost(s, e);
+
+    for (int reversed = 0; reversed < 2; ++reversed) {
+      // The node entered first after the move, and the one left last.
+      const int head = reversed ? last : first;
+      const int tail = reversed ? first : last;
+      const int* candidates = &inNeighbors_[head * k_];
+
+      for (size_t t = 0; t < k_; ++t) {
+        const int c = candidates[t];
+        if (dist(c, head) >= gain - kEpsilon) break;
+        const int q = at(pos_[c] + 1);
+        if (inSegment(c) || inSegment(q)) continue;
+
+        const double delta = dist(c, head) + dist(tail, q) - dist(c, q)
+                           + (reversed ? flip : 0.0) - gain;
+        if (!(delta < -kEpsilon)) continue;
+
+        segment_.clear();
+        for (int p = 0; p < length; ++p) segment_.push_back(at(s + p));
+        if (reversed) std::reverse(segment_.begin(), segment_.end());
+
+        next_.clear();
+        for (int p = 0; p < n_ - length; ++p) {
+          const int v = at(e + 1 + p);
+          next_.push_back(v);
+          if (v == c) next_.insert(next_.end(), segment_.begin(), segment_.end());
+        }
+        tour_.swap(next_);
+        refresh();
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+template <typename Metric>
+void AsymmetricLocalSearch<Metric>::improve(std::vector<int>& tour) {
+  if (static_cast<int>(tour.size()) != n_ || n_ < 3) {
+    return;
+  }
+  tour_.assign(tour.begin(), tour.end());
+  next_.reserve(n_);
+  refresh();
+
+  if (n_ == 3) {
+    // Only the orientation can change.
+    const int a = tour_[0], b = tour_[1], c = tour_[2];
+    if (dist(a, c) + dist(c, b) + dist(b, a) < dist(a, b) + dist(b, c) + dist(c, a)) {
+      std::swap(tour_[1], tour_[2]);
+    }
+  } else {
+    bool improved = true;
+    while (improved) {
+      improved = false;
+      for (int v = 0; v < n_; ++v) {
+        if (tryTwoOpt(pos_[v]) || tryOrOpt(pos_[v])) improved = true;
+      }
+    }
+  }
+
+  tour.assign(tour_.begin(), tour_.end());
+}
+
+template class AsymmetricLocalSearch<MatrixMetric>;
+template class AsymmetricLocalSearch<Int32MatrixMetric>;
+template class AsymmetricLocalSearch<UInt16MatrixMetric>;
+
+}; // namespace route_opt
@@ -0,0 +1,147 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+constexpr char kMagic[8] = {'R', 'O', 'P', 'T', 'C', 'K', 'P', 'T'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t size;
+  uint64_t checksum;
+};
+
+// FNV-1a.
+uint64_t checksum(const std::vector<char>& data) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : data) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+} // namespace
+
+CheckpointWriter::CheckpointWriter(std::string path)
+    : path_(std::move(path)), thread_([this] { run(); }) {}
+
+CheckpointWriter::~CheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+bool CheckpointWriter::submit(std::shared_ptr<Snapshot> snapshot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+  if (pending_) return false;
+  pending_ = std::move(snapshot);
+  wake_.notify_one();
+  return true;
+}
+
+void CheckpointWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] { return pending_ || stop_; });
+    if (!pending_) return;
+
+    // pending_ stays set while writing so that submit() reports busy.
+    const auto snapshot = pending_;
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      BinaryWriter out;
+      snapshot->encode(out);
+      writeCheckpoint(path_, out.data());
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+
+    pending_.reset();
+    if (error) error_ = error;
+    // Only after pending_ is cleared, so that a producer that saw done()
+    // can submit again straight away.
+    snapshot->done_.store(true, std::memory_order_release);
+  }
+}
+
+void writeCheckpoint(const std::string& path, const std::vector<char>& payload) {
+  Header header{};
+  std::copy(std::begin(kMagic), std::end(kMagic), header.magic);
+  header.version = kVersion;
+  header.size = payload.size();
+  header.checksum = checksum(payload);
+
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      throw std::runtime_error("Could not open file: " + temporary);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(payload.data(), payload.size());
+    if (!file.flush()) {
+      throw std::runtime_error("Could not write checkpoint: " + temporary);
+    }
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Could not replace checkpoint: " + path);
+  }
+}
+
+std::vector<char> readCheckpoint(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not open file: " + path);
+  }
+
+  Header header{};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      !std::equal(std::begin(kMagic), std::end(kMagic), header.magic)) {
+    throw std::runtime_error("Not a checkpoint file: " + path);
+  }
+  if (header.version != kVersion) {
+    throw std::runtime_error("Unsupported checkpoint version in " + path);
+  }
+
+  const auto begin = file.tellg();
+  file.seekg(0, std::ios::end);
+  const auto end = file.tellg();
+  file.seekg(begin);
+  if (static_cast<uint64_t>(end - begin) != header.size) {
+    throw std::runtime_error("Corrupt checkpoint: " + path);
+  }
+
+  std::vector<char> payload(header.size);
+  if (!file.read(payload.data(), payload.size()) || checksum(payload) != header.checksum) {
+    throw std::runtime_error("Corrupt checkpoint: " + path);
+  }
+  return payload;
+}
+
+uint64_t fingerprint(const PointVector& points) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const auto& point : points) {
+    for (double value : {point.x, point.y}) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      hash = (hash ^ bits) * 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+}; // namespace route_opt
@@ -0,0 +1,367 @@
+#include "contraction_hierarchy.h"
+#include <omp.h>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// Witness searches give up after settling this many nodes. A missed witness
+// only costs a redundant shortcut.
+constexpr int kWitnessSettleLimit = 500;
+
+struct Edge {
+  int node;
+  double weight;
+};
+
+// Dijkstra state shared by consecutive searches; reset() only clears the
+// entries the previous search touched.
+class Search {
+public:
+  explicit Search(size_t n) : distance_(n, kInfinity) {}
+
+  void reset() {
+    for (int v : touched_) distance_[v] = kInfinity;
+    touched_.clear();
+    heap_.clear();
+  }
+
+  void relax(int v, double d) {
+    if (d >= distance_[v]) return;
+    if (distance_[v] == kInfinity) touched_.push_back(v);
+    distance_[v] = d;
+    heap_.push_back({d, v});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+  }
+
+  // Next node to settle, skipping stale heap entries.
+  bool pop(int& v, double& d) {
+    while (!heap_.empty()) {
+      std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+      const auto [distance, node] = heap_.back();
+      heap_.pop_back();
+      if (distance == distance_[node]) {
+        v = node;
+        d = distance;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  double distance(int v) const { return distance_[v]; }
+
+private:
+  std::vector<double> distance_;
+  std::vector<int> touched_;
+  std::vector<std::pair<double, int>> heap_;
+};
+
+// The graph being contracted: arcs between nodes that are still present,
+// without self loops and keeping the cheapest of parallel arcs.
+class Contractor {
+public:
+  explicit Contractor(const RoadGraph& graph)
+      : out_(graph.nodeCount()), in_(graph.nodeCount()), deleted_(graph.nodeCount(), 0) {
+    for (size_t u = 0; u < graph.nodeCount(); ++u) {
+      for (int a = graph.offsets()[u]; a < graph.offsets()[u + 1]; ++a) {
+        if (graph.targets()[a] != static_cast<int>(u)) {
+          addArc(static_cast<int>(u), graph.targets()[a], graph.weights()[a]);
+        }
+      }
+    }
+  }
+
+  const std::vector<Edge>& out(int v) const { return out_[v]; }
+  const std::vector<Edge>& in(int v) const { return in_[v]; }
+
+  // Shortcuts that removing v needs: u -> v -> x is kept unless a witness
+  // search from u finds a path to x avoiding v that is no longer.
+  void shortcuts(int v, Search& search, std::vector<RoadGraph::Arc>& result) const {
+    result.clear();
+    double maxOut = 0.0;
+    for (const Edge& e : out_[v]) maxOut = std::max(maxOut, e.weight);
+
+    for (const Edge& from : in_[v]) {
+      witnessSearch(from.node, v, from.weight + maxOut, search);
+      for (const Edge& to : out_[v]) {
+        if (to.node == from.node) continue;
+        const double via = from.weight + to.weight;
+        if (search.distance(to.node) > via) {
+          result.push_back({from.node, to.node, via});
+        }
+      }
+    }
+  }
+
+  // Edge difference plus the number of already contracted neighbours, which
+  // spreads contraction evenly over the graph. Leaves `result` holding the
+  // shortcuts for v.
+  int priority(int v, Search& search, std::vector<RoadGraph::Arc>& result) const {
+    shortcuts(v, search, result);
+    const int removed = static_cast<int>(in_[v].size() + out_[v].size());
+    return 2 * (static_cast<int>(result.size()) - removed) + deleted_[v];
+  }
+
+  // Removes v and inserts `shortcuts`; returns how many arcs were new.
+  size_t contract(int v, const std::vector<RoadGraph::Arc>& shortcuts) {
+    for (const Edge& e : out_[v]) {
+      erase(in_[e.node], v);
+      ++deleted_[e.node];
+    }
+    for (const Edge& e : in_[v]) {
+      erase(out_[e.node], v);
+      ++deleted_[e.node];
+    }
+    out_[v].clear();
+    out_[v].shrink_to_fit();
+    in_[v].clear();
+    in_[v].shrink_to_fit();
+
+    size_t added = 0;
+    for (const auto& arc : shortcuts) {
+      added += addArc(arc.from, arc.to, arc.weight);
+    }
+    return added;
+  }
+
+private:
+  std::vector<std::vector<Edge>> out_;
+  std::vector<std::vector<Edge>> in_;
+  std::vector<int> deleted_;
+
+  bool addArc(int u, int v, double weight) {
+    for (Edge& e : out_[u]) {
+      if (e.node != v) continue;
+      if (weight < e.weight) {
+        e.weight = weight;
+        for (Edge& back : in_[v]) {
+          if (back.node == u) back.weight = weight;
+        }
+      }
+      return false;
+    }
+    out_[u].push_back({v, weight});
+    in_[v].push_back({u, weight});
+    return true;
+  }
+
+  static void erase(std::vector<Edge>& edges, int v) {
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                               [v](const Edge& e) { return e.node == v; }),
+                edges.end());
+  }
+
+  // Distances from `source` that avoid `skip`, settled up to `limit`.
+  // Tentative distances left in the heap are still lengths of real paths.
+  void witnessSearch(int source, int skip, double limit, Search& search) const {
+    search.reset();
+    search.relax(source, 0.0);
+    int settled = 0;
+    int v;
+    double d;
+    while (search.pop(v, d) && d <= limit && ++settled <= kWitnessSettleLimit) {
+      for (const Edge& e : out_[v]) {
+        if (e.node != skip) search.relax(e.node, d + e.weight);
+      }
+    }
+  }
+};
+
+// Upward Dijkstra over `graph`, calling visit(node, distance) for every
+// settled node. A node is stalled, and neither visited nor expanded, when
+// an arc of `stall` (the opposite direction) shows its distance is not
+// shortest: such a node cannot be where a shortest path turns.
+template <typename Graph, typename Visit>
+void upwardSearch(const Graph& graph, const Graph& stall, int source, Search& search,
+                  Visit&& visit) {
+  search.reset();
+  search.relax(source, 0.0);
+  int v;
+  double d;
+  while (search.pop(v, d)) {
+    bool stalled = false;
+    for (int a = stall.offsets[v]; a < stall.offsets[v + 1] && !stalled; ++a) {
+      stalled = search.distance(stall.heads[a]) + stall.weights[a] < d;
+    }
+    if (stalled) continue;
+
+    visit(v, d);
+    for (int a = graph.offsets[v]; a < graph.offsets[v + 1]; ++a) {
+      search.relax(graph.heads[a], d + graph.weights[a]);
+    }
+  }
+}
+} // namespace
+
+ContractionHierarchy::ContractionHierarchy(const RoadGraph& graph) {
+  const int n = static_cast<int>(graph.nodeCount());
+  Contractor contractor(graph);
+
+  using Entry = std::pair<int, int>;
+  std::vector<Entry> initial(n);
+#pragma omp parallel
+  {
+    Search search(n);
+    std::vector<RoadGraph::Arc> shortcuts;
+#pragma omp for schedule(dynamic, 256)
+    for (int v = 0; v < n; ++v) {
+      initial[v] = {contractor.priority(v, search, shortcuts), v};
+    }
+  }
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue(std::greater<>(),
+                                                                       std::move(initial));
+
+  // Upward arcs in graph ids: forward u -> w, backward w -> u stored as
+  // {u, w, weight}, with w contracted after u.
+  std::vector<RoadGraph::Arc> forward;
+  std::vector<RoadGraph::Arc> backward;
+  std::vector<RoadGraph::Arc> shortcuts;
+  Search search(n);
+  rank_.assign(n, -1);
+  int next = 0;
+
+  // Priorities are refreshed lazily: a node whose priority grew since it
+  // was queued goes back into the queue instead of being contracted.
+  while (!queue.empty()) {
+    const int v = queue.top().second;
+    queue.pop();
+    const int priority = contractor.priority(v, search, shortcuts);
+    if (!queue.empty() && priority > queue.top().first) {
+      queue.push({priority, v});
+      continue;
+    }
+
+    rank_[v] = next++;
+    for (const Edge& e : contractor.out(v)) forward.push_back({v, e.node, e.weight});
+    for (const Edge& e : contractor.in(v)) backward.push_back({v, e.node, e.weight});
+    shortcuts_ += contractor.contract(v, shortcuts);
+  }
+
+  auto build = [&](const std::vector<RoadGraph::Arc>& arcs, UpwardGraph& upward) {
+    upward.offsets.assign(n + 1, 0);
+    for (const auto& arc : arcs) ++upward.offsets[rank_[arc.from] + 1];
+    for (int v = 0; v < n; ++v) upward.offsets[v + 1] += upward.offsets[v];
+
+    upward.heads.resize(arcs.size());
+    upward.weights.resize(arcs.size());
+    std::vector<int> fill(upward.offsets.begin(), upward.offsets.end() - 1);
+    for (const auto& arc : arcs) {
+      const int slot = fill[rank_[arc.from]]++;
+      upward.heads[slot] = rank_[arc.to];
+      upward.weights[slot] = arc.weight;
+    }
+  };
+  build(forward, forward_);
+  build(backward, backward_);
+}
+
+template <typename Emit>
+void ContractionHierarchy::forEachRow(const std::vector<int>& sources,
+                                      const std::vector<int>& targets, Emit&& emit) const {
+  const int n = static_cast<int>(rank_.size());
+  for (const auto* nodes : {&sources, &targets}) {
+    for (int v : *nodes) {
+      if (v < 0 || v >= n) {
+        throw std::invalid_argument("Node outside the road graph");
+      }
+    }
+  }
+
+  // Backward pass. Every thread collects (node, target, distance) entries,
+  // which are then sorted into per-node buckets.
+  struct BucketEntry {
+    int target;
+    double distance;
+  };
+  std::vector<std::vector<std::pair<int, BucketEntry>>> found(omp_get_max_threads());
+#pragma omp parallel
+  {
+    Search search(n);
+    auto& local = found[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 16)
+    for (size_t j = 0; j < targets.size(); ++j) {
+      upwardSearch(backward_, forward_, rank_[targets[j]], search, [&](int v, double d) {
+        local.push_back({v, {static_cast<int>(j), d}});
+      });
+    }
+  }
+
+  std::vector<size_t> bucketStart(n + 1, 0);
+  for (const auto& local : found) {
+    for (const auto& entry : local) ++bucketStart[entry.first + 1];
+  }
+  for (int v = 0; v < n; ++v) bucketStart[v + 1] += bucketStart[v];
+  std::vector<BucketEntry> buckets(bucketStart[n]);
+  {
+    std::vector<size_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (auto& local : found) {
+      for (const auto& entry : local) buckets[fill[entry.first]++] = entry.second;
+      local = {};
+    }
+  }
+
+  // Forward pass; each source fills one row.
+#pragma omp parallel
+  {
+    Search search(n);
+    std::vector<double> row(targets.size());
+#pragma omp for schedule(dynamic, 16)
+    for (size_t i = 0; i < sources.size(); ++i) {
+      std::fill(row.begin(), row.end(), kInfinity);
+      upwardSearch(forward_, backward_, rank_[sources[i]], search, [&](int v, double d) {
+        for (size_t b = bucketStart[v]; b < bucketStart[v + 1]; ++b) {
+          row[buckets[b].target] = std::min(row[buckets[b].target], d + buckets[b].distance);
+        }
+      });
+      emit(i, row.data());
+    }
+  }
+}
+
+std::vector<std::vector<double>> ContractionHierarchy::manyToMany(
+    const std::vector<int>& sources, const std::vector<int>& targets) const {
+  std::vector<std::vector<double>> distances(sources.size());
+  forEachRow(sources, targets, [&](size_t i, const double* row) {
+    distances[i].assign(row, row + targets.size());
+  });
+  return distances;
+}
+
+QuantizedMatrix ContractionHierarchy::manyToMany(const std::vector<int>& nodes,
+                                                 DistancePrecision precision,
+                                                 double quantum) const {
+  QuantizedMatrix matrix(nodes.size(), precision, quantum);
+  // Exceptions cannot leave the parallel region; the first one is rethrown.
+  std::exception_ptr error;
+  forEachRow(nodes, nodes, [&](size_t i, const double* row) {
+    if (std::any_of(row, row + nodes.size(), [](double d) { return d == kInfinity; })) {
+#pragma omp critical(manyToManyError)
+      if (!error) {
+        error = std::make_exception_ptr(
+            std::runtime_error("Entry " + std::to_string(i) + " (road graph node " +
+                               std::to_string(nodes[i]) + ") cannot reach every other entry"));
+      }
+      return;
+    }
+    try {
+      matrix.setRow(i, row);
+    } catch (...) {
+#pragma omp critical(manyToManyError)
+      if (!error) error = std::current_exception();
+    }
+  });
+  if (error) std::rethrow_exception(error);
+  return matrix;
+}
+
+}; // namespace route_opt
@@ -1,5 +1,8 @@
 #include "cuda/optimizer.cuh"
 #include "cuda/two_opt.cuh"
+#include "decomposition.h"
+#include "local_search.h"
+#include "memetic.h"
 
 namespace route_opt {
     namespace cuda {
@@ -8,10 +11,21 @@ namespace route_opt {
                 switch (optimizer) {
                     case RouteAlgorithm::TwoOpt:
                         return new TwoOptOptimizer();
+                    case RouteAlgorithm::Decomposition:
+                        return new DecompositionOptimizer();
+                    case RouteAlgorithm::Memetic:
+                        return new MemeticOptimizer();
                     default:
                         return nullptr;
                 }
             };
         }
     }
+
+    RouteOptimizer *RouteOptimizer::createOptimizer(bool useGPU) {
+        if (useGPU) {
+            return cuda::factory::createCUDAOptimizer(cuda::factory::RouteAlgorithm::TwoOpt);
+        }
+        return new LocalSearchOptimizer();
+    }
 }
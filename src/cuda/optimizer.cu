@@ -1,54 +1,87 @@
 #include "cuda/optimizer.cuh"
 #include "cuda/two_opt.cuh"
+#include "route_generator.h"
+#include <thrust/copy.h>
 #include <thrust/device_vector.h>
-#include <thrust/host_vector.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <thrust/transform_reduce.h>
+#include <algorithm>
 #include <random>
 #include <numeric>
 
 namespace route_opt {
     namespace cuda {
-        thrust::device_vector<double> CUDAOptimizer::prepareDistances(
-                const PointVector &points) {
+        namespace {
+            struct RouteEdgeFunctor {
+                const double *distances;
+                const int *route;
+                const int n;
+
+                __host__ __device__
+                RouteEdgeFunctor(const double *d, const int *r, int size) : distances(d), route(r), n(size) {
+                }
+
+                __host__ __device__
+                double operator()(int i) const {
+                    return distances[route[i] * n + route[i + 1 == n ? 0 : i + 1]];
+                }
+            };
+        }
+
+        const thrust::device_vector<double> &CUDAOptimizer::prepareDistances(
+                const PointVector &points, SolverWorkspace &workspace) {
             const int n = points.size();
-            thrust::host_vector<double> distances_h(n * n);
+            double *distances_h = workspace.allocate<double>(n * n);
+            RouteGenerator().generateEuclidean(points, distances_h);
+
+            distances_d_.resize(n * n);
+            thrust::copy(distances_h, distances_h + n * n, distances_d_.begin());
+            return distances_d_;
+        }
+
+        const thrust::device_vector<double> &CUDAOptimizer::prepareDistances(
+                const std::vector<std::vector<double>> &distances, SolverWorkspace &workspace) {
+            const int n = distances.size();
+            double *distances_h = workspace.allocate<double>(n * n);
 
-#pragma omp parallel for collapse(2)
             for (int i = 0; i < n; ++i) {
-                for (int j = 0; j < n; ++j) {
-                    distances_h[i * n + j] = points[i].distanceTo(points[j]);
-                }
+                std::copy(distances[i].begin(), distances[i].end(), distances_h + i * n);
             }
 
-            return thrust::device_vector<double>(distances_h);
+            distances_d_.resize(n * n);
+            thrust::copy(distances_h, distances_h + n * n, distances_d_.begin());
+            return distances_d_;
         }
 
-        thrust::device_vector<int> CUDAOptimizer::initializeRoute(int size) {
-            thrust::host_vector<int> route_h(size);
-            std::iota(route_h.begin(), route_h.end(), 0);
+        thrust::device_vector<int> &CUDAOptimizer::initializeRoute(int size, SolverWorkspace &workspace) {
+            int *route_h = workspace.allocate<int>(size);
+            std::iota(route_h, route_h + size, 0);
+            std::shuffle(route_h, route_h + size, rng_);
 
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::shuffle(route_h.begin(), route_h.end(), gen);
-
-            return thrust::device_vector<int>(route_h);
+            route_d_.resize(size);
+            thrust::copy(route_h, route_h + size, route_d_.begin());
+            return route_d_;
         }
 
+        // Sums the n tour edges on the device; only the total comes back.
         double CUDAOptimizer::computeTotalDistance(
                 const thrust::device_vector<double> &distances,
                 const thrust::device_vector<int> &route) {
-
             const int n = route.size();
-            thrust::host_vector<int> route_h = route;
-            thrust::host_vector<double> distances_h = distances; // Changed to host_vector
-
-            double total = 0.0;
-
-            for (int i = 0; i < n; ++i) {
-                int from = route_h[i];
-                int to = route_h[(i + 1) % n];
-                total += distances_h[from * n + to];
+            if (n == 0) {
+                return 0.0;
             }
-            return total;
+
+            return thrust::transform_reduce(
+                    thrust::cuda::par(pool_),
+                    thrust::make_counting_iterator<int>(0),
+                    thrust::make_counting_iterator<int>(n),
+                    RouteEdgeFunctor(thrust::raw_pointer_cast(distances.data()),
+                                     thrust::raw_pointer_cast(route.data()), n),
+                    0.0,
+                    thrust::plus<double>());
         }
     }
 }
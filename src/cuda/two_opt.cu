@@ -1,29 +1,106 @@
 #include "cuda/optimizer.cuh"
 #include "cuda/two_opt.cuh"
+#include "cuda/or_opt.cuh"
+#include "lower_bound.h"
+#include "route_generator.h"
 #include <thrust/execution_policy.h>
-#include <thrust/host_vector.h>
+#include <thrust/extrema.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/logical.h>
+#include <thrust/scan.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <thrust/transform.h>
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
+#include <vector>
 
 namespace route_opt {
     namespace cuda {
+        namespace {
+            void applyMove(int *path, const or_opt::Move &move) {
+                if (move.type == or_opt::Reversal) {
+                    std::reverse(path + move.i + 1, path + move.j + 1);
+                    return;
+                }
+
+                // Rotate the segment into place after path[j], then flip it if needed.
+                int *segment;
+                if (move.j < move.i) {
+                    std::rotate(path + move.j + 1, path + move.i, path + move.i + move.length);
+                    segment = path + move.j + 1;
+                } else {
+                    std::rotate(path + move.i, path + move.i + move.length, path + move.j + 1);
+                    segment = path + move.j + 1 - move.length;
+                }
+                if (move.type == or_opt::ReversedInsertion) {
+                    std::reverse(segment, segment + move.length);
+                }
+            }
+        }
+
         Route TwoOptOptimizer::findOptimalRoute(const PointVector &points) {
             const int n = points.size();
+            SolverWorkspace &workspace = beginSolve();
+
+            const auto &distances_d = prepareDistances(points, workspace);
+            auto &route_d = initializeRoute(n, workspace);
+
+            const double lower_bound =
+                gapTolerance_ > 0.0 ? certifiedLowerBound(points) : 0.0;
+
+            runTwoOpt(distances_d, route_d, n, lower_bound);
+
+            Route result;
+            result.path.resize(n);
+            thrust::copy(route_d.begin(), route_d.end(), result.path.begin());
+            result.totalDistance = computeTotalDistance(distances_d, route_d);
 
-            auto distances_d = prepareDistances(points);
-            auto route_d = initializeRoute(n);
-            thrust::device_vector<bool> improved_d(1);
+            return result;
+        }
+
+        Route TwoOptOptimizer::findOptimalRouteForMatrix(
+                const std::vector<std::vector<double>> &distances) {
+            if (!utils::isValidDistanceMatrix(distances)) {
+                throw std::invalid_argument("Invalid distance matrix");
+            }
+            const int n = distances.size();
+            SolverWorkspace &workspace = beginSolve();
+
+            const auto &distances_d = prepareDistances(distances, workspace);
+            auto &route_d = initializeRoute(n, workspace);
+
+            // TwoOptSwapFunctor prices a reversed segment as free, which only
+            // holds for symmetric distances.
+            if (utils::isSymmetric(distances)) {
+                runTwoOpt(distances_d, route_d, n, 0.0);
+            } else {
+                runAsymmetric(distances_d, route_d, n, workspace);
+            }
+
+            Route result;
+            result.path.resize(n);
+            thrust::copy(route_d.begin(), route_d.end(), result.path.begin());
+            result.totalDistance = computeTotalDistance(distances_d, route_d);
+
+            return result;
+        }
+
+        void TwoOptOptimizer::runTwoOpt(const thrust::device_vector<double> &distances_d,
+                                        thrust::device_vector<int> &route_d,
+                                        int n, double lower_bound) {
+            if (n < 4) {
+                return;
+            }
+
+            // One flag per (i, i + 2) pair evaluated by the swap functor.
+            improved_d_.resize(n - 2);
 
             const int max_iterations = pow(2, n);
             int iteration = 0;
 
             do {
-                improved_d[0] = false;
-                thrust::counting_iterator<int> begin(0);
-                thrust::counting_iterator<int> end(n - 2);
-
                 route_opt::cuda::two_opt::TwoOptSwapFunctor swap_op(
                         thrust::raw_pointer_cast(distances_d.data()),
                         thrust::raw_pointer_cast(route_d.data()),
@@ -45,23 +122,77 @@ namespace route_opt {
                         );
 
                 thrust::transform(
-                        thrust::device,
+                        thrust::cuda::par(pool_),
                         pairs_begin,
                         pairs_end,
-                        improved_d.begin(),
+                        improved_d_.begin(),
                         swap_op
                         );
 
                 iteration++;
-            } while (thrust::any_of(improved_d.begin(), improved_d.end(),
+
+                if (lower_bound > 0.0 &&
+                    optimalityGap(computeTotalDistance(distances_d, route_d), lower_bound) <= gapTolerance_) {
+                    break;
+                }
+            } while (thrust::any_of(thrust::cuda::par(pool_), improved_d_.begin(), improved_d_.end(),
                                     thrust::identity<bool>()) && iteration < max_iterations);
+        }
 
-            Route result;
-            thrust::host_vector<int> route_h = route_d;
-            result.path.assign(route_h.begin(), route_h.end());
-            result.totalDistance = computeTotalDistance(route_d, distances_d);
+        // Best-improvement search over reversal and Or-opt moves: every
+        // position evaluates its moves in parallel against cached forward and
+        // backward prefix costs, the best one is applied on the host.
+        void TwoOptOptimizer::runAsymmetric(const thrust::device_vector<double> &distances_d,
+                                            thrust::device_vector<int> &route_d, int n,
+                                            SolverWorkspace &workspace) {
+            if (n < 4) {
+                return;
+            }
 
-            return result;
+            forward_d_.resize(n);
+            backward_d_.resize(n);
+            moves_d_.resize(n - 1);
+            int *path = workspace.allocate<int>(n);
+            thrust::copy(route_d.begin(), route_d.end(), path);
+
+            const double *distances = thrust::raw_pointer_cast(distances_d.data());
+            const int max_iterations = n * n;
+
+            for (int iteration = 0; iteration < max_iterations; ++iteration) {
+                const int *route = thrust::raw_pointer_cast(route_d.data());
+
+                thrust::transform(thrust::cuda::par(pool_),
+                                  thrust::make_counting_iterator<int>(0),
+                                  thrust::make_counting_iterator<int>(n),
+                                  forward_d_.begin(),
+                                  or_opt::EdgeCostFunctor(distances, route, n, false));
+                thrust::inclusive_scan(thrust::cuda::par(pool_), forward_d_.begin(), forward_d_.end(), forward_d_.begin());
+                thrust::transform(thrust::cuda::par(pool_),
+                                  thrust::make_counting_iterator<int>(0),
+                                  thrust::make_counting_iterator<int>(n),
+                                  backward_d_.begin(),
+                                  or_opt::EdgeCostFunctor(distances, route, n, true));
+                thrust::inclusive_scan(thrust::cuda::par(pool_), backward_d_.begin(), backward_d_.end(), backward_d_.begin());
+
+                thrust::transform(thrust::cuda::par(pool_),
+                                  thrust::make_counting_iterator<int>(0),
+                                  thrust::make_counting_iterator<int>(n - 1),
+                                  moves_d_.begin(),
+                                  or_opt::AsymmetricMoveFunctor(
+                                          distances, route,
+                                          thrust::raw_pointer_cast(forward_d_.data()),
+                                          thrust::raw_pointer_cast(backward_d_.data()),
+                                          n, 3));
+
+                const or_opt::Move best = *thrust::min_element(
+                        thrust::cuda::par(pool_), moves_d_.begin(), moves_d_.end(), or_opt::MoveLess());
+                if (best.type == or_opt::None || best.delta > -1e-10) {
+                    break;
+                }
+
+                applyMove(path, best);
+                thrust::copy(path, path + n, route_d.begin());
+            }
         }
 
 
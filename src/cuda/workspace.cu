@@ -0,0 +1,52 @@
+#include "cuda/workspace.cuh"
+#include <cuda_runtime.h>
+#include <new>
+
+namespace route_opt {
+    namespace cuda {
+        DevicePool::~DevicePool() {
+            for (auto &block : free_) {
+                cudaFree(block.first);
+            }
+            for (auto &block : used_) {
+                cudaFree(block.first);
+            }
+        }
+
+        char *DevicePool::allocate(std::ptrdiff_t bytes) {
+            // Smallest free block that fits.
+            size_t best = free_.size();
+            for (size_t i = 0; i < free_.size(); ++i) {
+                if (free_[i].second >= static_cast<size_t>(bytes) &&
+                    (best == free_.size() || free_[i].second < free_[best].second)) {
+                    best = i;
+                }
+            }
+
+            if (best < free_.size()) {
+                used_.push_back(free_[best]);
+                free_[best] = free_.back();
+                free_.pop_back();
+                return used_.back().first;
+            }
+
+            char *ptr = nullptr;
+            if (cudaMalloc(&ptr, bytes) != cudaSuccess) {
+                throw std::bad_alloc();
+            }
+            used_.push_back({ptr, static_cast<size_t>(bytes)});
+            return ptr;
+        }
+
+        void DevicePool::deallocate(char *ptr, size_t) {
+            for (size_t i = 0; i < used_.size(); ++i) {
+                if (used_[i].first == ptr) {
+                    free_.push_back(used_[i]);
+                    used_[i] = used_.back();
+                    used_.pop_back();
+                    return;
+                }
+            }
+        }
+    }
+}
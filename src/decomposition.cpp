@@ -0,0 +1,347 @@
+#include "decomposition.h"
+#include "checkpoint.h"
+#include "local_search.h"
+#include "spatial_index.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr char kCheckpointTag[] = "decomposition";
+
+// What a checkpoint holds: cluster tours solved so far, or the stitched tour.
+enum Phase : uint8_t { kClusters = 0, kStitched = 1 };
+
+// Cluster tours solved so far, copied out of the shared order.
+struct ClusterSnapshot : Snapshot {
+  std::vector<uint64_t> key;
+  std::vector<char> solved;
+  std::vector<int> order;
+
+  void encode(BinaryWriter& out) const override {
+    out.writeString(kCheckpointTag);
+    out.write(key.data(), key.size());
+    out.write<uint8_t>(kClusters);
+    out.write(solved.data(), solved.size());
+    out.write(order.data(), order.size());
+  }
+};
+} // namespace
+
+DecompositionOptimizer::DecompositionOptimizer(OptimizerFactory factory,
+                                               const DecompositionConfig& config)
+    : factory_(std::move(factory)), config_(config) {
+  if (!factory_) {
+    factory_ = [] { return new LocalSearchOptimizer(); };
+  }
+  config_.clusterSize = std::max<size_t>(config_.clusterSize, 4);
+}
+
+Route DecompositionOptimizer::solve(const PointVector& points) const {
+  if (points.size() < 4) {
+    Route route;
+    route.path.resize(points.size());
+    std::iota(route.path.begin(), route.path.end(), 0);
+    route.totalDistance = utils::tourLength(points, route.path);
+    return route;
+  }
+
+  std::unique_ptr<RouteOptimizer> optimizer(factory_());
+  if (!optimizer) {
+    throw std::runtime_error("Failed to create cluster optimizer");
+  }
+  Route route = optimizer->findOptimalRoute(points);
+  if (route.path.size() != points.size()) {
+    throw std::runtime_error("Cluster optimizer returned an incomplete route");
+  }
+  return route;
+}
+
+std::vector<size_t> DecompositionOptimizer::partition(const PointVector& points,
+                                                      std::vector<int>& order) const {
+  std::vector<size_t> bounds{0};
+  std::vector<std::pair<size_t, size_t>> stack{{0, order.size()}};
+
+  // Depth-first kd bisection along the wider extent of each range. Pushing
+  // the upper half first keeps neighbouring leaves adjacent in `order`.
+  while (!stack.empty()) {
+    const auto [begin, end] = stack.back();
+    stack.pop_back();
+
+    if (end - begin <= config_.clusterSize) {
+      bounds.push_back(end);
+      continue;
+    }
+
+    double minX = std::numeric_limits<double>::max(), maxX = -minX;
+    double minY = minX, maxY = -minX;
+    for (size_t i = begin; i < end; ++i) {
+      const Point& p = points[order[i]];
+      minX = std::min(minX, p.x);
+      maxX = std::max(maxX, p.x);
+      minY = std::min(minY, p.y);
+      maxY = std::max(maxY, p.y);
+    }
+    const bool splitX = maxX - minX >= maxY - minY;
+
+    const size_t mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&points, splitX](int a, int b) {
+                       return splitX ? points[a].x < points[b].x : points[a].y < points[b].y;
+                     });
+
+    stack.push_back({mid, end});
+    stack.push_back({begin, mid});
+  }
+
+  return bounds;
+}
+
+void DecompositionOptimizer::solveClusters(const PointVector& points,
+                                           const std::vector<uint64_t>& key,
+                                           const std::vector<size_t>& bounds,
+                                           std::vector<char>& solved,
+                                           std::vector<int>& order) const {
+  const long clusters = static_cast<long>(bounds.size()) - 1;
+
+  // Declared before the loop so that its destructor finishes the last
+  // snapshot before returning.
+  std::unique_ptr<CheckpointWriter> writer;
+  if (!config_.checkpointPath.empty()) {
+    writer = std::make_unique<CheckpointWriter>(config_.checkpointPath);
+  }
+  const auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(config_.checkpointInterval));
+  auto nextCheckpoint = Clock::now() + interval;
+
+  // Solve every cluster independently; each writes its tour back into its
+  // own range of `order`.
+  std::exception_ptr failure;
+#pragma omp parallel for schedule(dynamic)
+  for (long c = 0; c < clusters; ++c) {
+    if (solved[c]) continue;
+    try {
+      const std::vector<int> ids(order.begin() + bounds[c], order.begin() + bounds[c + 1]);
+      PointVector subset;
+      subset.reserve(ids.size());
+      for (int id : ids) {
+        subset.push_back(points[id]);
+      }
+
+      const Route route = solve(subset);
+      // Snapshots read every range, so write-back takes the same lock.
+#pragma omp critical(decompositionProgress)
+      {
+        for (size_t i = 0; i < ids.size(); ++i) {
+          order[bounds[c] + i] = ids[route.path[i]];
+        }
+        solved[c] = 1;
+
+        if (writer && Clock::now() >= nextCheckpoint) {
+          auto snapshot = std::make_shared<ClusterSnapshot>();
+          snapshot->key = key;
+          snapshot->solved = solved;
+          snapshot->order = order;
+          try {
+            if (writer->submit(std::move(snapshot))) nextCheckpoint = Clock::now() + interval;
+          } catch (...) {
+            if (!failure) failure = std::current_exception();
+          }
+        }
+      }
+    } catch (...) {
+#pragma omp critical(decompositionProgress)
+      failure = std::current_exception();
+    }
+  }
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+}
+
+std::vector<int> DecompositionOptimizer::stitch(const PointVector& points,
+                                                const PointVector& centroids,
+                                                const std::vector<int>& visit,
+                                                const std::vector<size_t>& bounds,
+                                                const std::vector<int>& order) const {
+  const long clusters = static_cast<long>(bounds.size()) - 1;
+
+  // Open each cluster cycle at the edge that best connects the exit of the
+  // previous cluster to the centroid of the next one.
+  std::vector<int> tour;
+  tour.reserve(order.size());
+  Point from = centroids[visit.back()];
+  for (long t = 0; t < clusters; ++t) {
+    const int c = visit[t];
+    const Point& to = centroids[visit[(t + 1) % clusters]];
+    const int* cycle = &order[bounds[c]];
+    const long size = static_cast<long>(bounds[c + 1] - bounds[c]);
+
+    long bestEdge = 0;
+    bool bestForward = true;
+    double bestCost = std::numeric_limits<double>::max();
+    for (long i = 0; i < size; ++i) {
+      const Point& u = points[cycle[i]];
+      const Point& v = points[cycle[(i + 1) % size]];
+      const double removed = size > 1 ? u.distanceTo(v) : 0.0;
+      const double forward = from.distanceTo(v) + u.distanceTo(to) - removed;
+      const double backward = from.distanceTo(u) + v.distanceTo(to) - removed;
+      if (forward < bestCost) {
+        bestCost = forward;
+        bestEdge = i;
+        bestForward = true;
+      }
+      if (backward < bestCost) {
+        bestCost = backward;
+        bestEdge = i;
+        bestForward = false;
+      }
+    }
+
+    for (long j = 0; j < size; ++j) {
+      const long i = bestForward ? (bestEdge + 1 + j) % size
+                                 : (bestEdge - j + size) % size;
+      tour.push_back(cycle[i]);
+    }
+    from = points[tour.back()];
+  }
+  return tour;
+}
+
+void DecompositionOptimizer::resume(const std::vector<uint64_t>& key,
+                                    const std::vector<int>& clusterOf,
+                                    const std::vector<size_t>& bounds,
+                                    std::vector<char>& solved, std::vector<int>& order,
+                                    std::vector<int>& tour) const {
+  const std::string& path = config_.resumePath;
+  const auto payload = readCheckpoint(path);
+  BinaryReader in(payload);
+  if (in.readString() != kCheckpointTag) {
+    throw std::runtime_error("Not a decomposition checkpoint: " + path);
+  }
+  std::vector<uint64_t> saved(key.size());
+  in.read(saved.data(), saved.size());
+  if (saved != key) {
+    throw std::runtime_error("Checkpoint " + path +
+                             " was saved for a different instance or configuration");
+  }
+
+  const size_t n = order.size();
+  std::vector<int> nodes(n);
+  const auto phase = in.read<uint8_t>();
+  if (phase == kClusters) {
+    in.read(solved.data(), solved.size());
+    in.read(nodes.data(), n);
+  } else if (phase == kStitched) {
+    in.read(nodes.data(), n);
+  } else {
+    throw std::runtime_error("Corrupt checkpoint: " + path);
+  }
+  if (!in.atEnd()) {
+    throw std::runtime_error("Corrupt checkpoint: " + path);
+  }
+
+  // Every node exactly once and, before stitching, inside its own cluster.
+  std::vector<char> seen(n, 0);
+  for (size_t c = 0; c + 1 < bounds.size(); ++c) {
+    for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+      const int v = nodes[i];
+      if (v < 0 || size_t(v) >= n || seen[v] ||
+          (phase == kClusters && clusterOf[v] != static_cast<int>(c))) {
+        throw std::runtime_error("Corrupt checkpoint: " + path);
+      }
+      seen[v] = 1;
+    }
+  }
+  if (phase == kClusters) {
+    order = std::move(nodes);
+  } else {
+    tour = std::move(nodes);
+  }
+}
+
+Route DecompositionOptimizer::findOptimalRoute(const PointVector& points) {
+  const size_t n = points.size();
+  if (n <= config_.clusterSize) {
+    return solve(points);
+  }
+
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  const std::vector<size_t> bounds = partition(points, order);
+  const long clusters = static_cast<long>(bounds.size()) - 1;
+
+  // Cluster membership and centroids do not depend on the order that
+  // solving gives each range.
+  std::vector<int> clusterOf(n);
+  PointVector centroids(clusters, Point{0.0, 0.0});
+  for (long c = 0; c < clusters; ++c) {
+    for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+      clusterOf[order[i]] = c;
+      centroids[c].x += points[order[i]].x;
+      centroids[c].y += points[order[i]].y;
+    }
+    const double size = double(bounds[c + 1] - bounds[c]);
+    centroids[c].x /= size;
+    centroids[c].y /= size;
+  }
+
+  const std::vector<uint64_t> key = {fingerprint(points), n, config_.clusterSize,
+                                     config_.repairNeighbors};
+  std::vector<char> solved(clusters, 0);
+  std::vector<int> tour;
+  if (!config_.resumePath.empty()) {
+    resume(key, clusterOf, bounds, solved, order, tour);
+  }
+
+  if (tour.empty()) {
+    solveClusters(points, key, bounds, solved, order);
+
+    const std::vector<int> visit = solve(centroids).path;
+    tour = stitch(points, centroids, visit, bounds, order);
+
+    // Always saved: the repair pass that follows can be long.
+    if (!config_.checkpointPath.empty()) {
+      BinaryWriter out;
+      out.writeString(kCheckpointTag);
+      out.write(key.data(), key.size());
+      out.write<uint8_t>(kStitched);
+      out.write(tour.data(), tour.size());
+      writeCheckpoint(config_.checkpointPath, out.data());
+    }
+  }
+
+  // Boundary repair: start local search from the nodes whose candidate
+  // neighbourhood crosses into another cluster.
+  const size_t k = std::min(config_.repairNeighbors, n - 1);
+  const std::vector<int> neighbors = SpatialGrid(points).nearestNeighbors(k);
+  std::vector<int> boundary;
+  for (size_t v = 0; v < n; ++v) {
+    for (size_t i = 0; i < k; ++i) {
+      const int w = neighbors[v * k + i];
+      if (w >= 0 && clusterOf[w] != clusterOf[v]) {
+        boundary.push_back(v);
+        break;
+      }
+    }
+  }
+  LocalSearch(EuclideanMetric(points), neighbors, k).improve(tour, boundary);
+
+  Route result;
+  result.path = std::move(tour);
+  result.totalDistance = utils::tourLength(points, result.path);
+  return result;
+}
+
+}; // namespace route_opt
@@ -0,0 +1,410 @@
+#include "local_search.h"
+#include "asymmetric.h"
+#include "route_generator.h"
+#include "spatial_index.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+// SpatialGrid ranks candidates by Euclidean distance; re-rank each row when
+// that order does not carry over to the metric.
+template <typename Metric>
+void sortCandidates(const Metric& metric, int* neighbors, size_t n, size_t k) {
+  if constexpr (!Metric::euclideanOrder) {
+    for (size_t v = 0; v < n; ++v) {
+      int* row = neighbors + v * k;
+      int* end = std::find(row, row + k, -1);
+      std::sort(row, end, [&](int a, int b) { return metric(v, a) < metric(v, b); });
+    }
+  }
+}
+} // namespace
+
+// Greedy edge matching over the candidate edges: shortest edges first, as
+// long as both ends have degree < 2 and no subtour closes. The remaining
+// fragments are chained in Hilbert order of their first endpoint.
+std::vector<int> greedyTour(const PointVector& points,
+                            const std::vector<int>& neighbors, size_t k) {
+  std::vector<int> tour(points.size());
+  greedyTour(EuclideanMetric(points), neighbors.data(), k, tour.data(),
+             std::pmr::get_default_resource());
+  return tour;
+}
+
+template <typename Metric>
+void greedyTour(const Metric& metric, const int* neighbors, size_t k,
+                int* tour, std::pmr::memory_resource* memory) {
+  static_assert(Metric::coordinateBased, "greedyTour orders fragments along a Hilbert curve");
+  const PointVector& points = metric.points();
+  const int n = static_cast<int>(points.size());
+
+  struct Candidate {
+    typename Metric::value_type length;
+    int a, b;
+  };
+  std::pmr::vector<Candidate> edges(memory);
+  edges.reserve(n * k);
+  for (int a = 0; a < n; ++a) {
+    for (size_t i = 0; i < k; ++i) {
+      const int b = neighbors[a * k + i];
+      if (b > a) edges.push_back({metric(a, b), a, b});
+      else if (b >= 0) {
+        const int* row = &neighbors[b * k];
+        if (std::find(row, row + k, a) == row + k) {
+          edges.push_back({metric(a, b), b, a});
+        }
+      }
+    }
+  }
+  std::sort(edges.begin(), edges.end(),
+            [](const Candidate& l, const Candidate& r) { return l.length < r.length; });
+
+  std::pmr::vector<int> link(2 * n, -1, memory);
+  std::pmr::vector<int> fragment(n, memory);
+  std::iota(fragment.begin(), fragment.end(), 0);
+  auto find = [&fragment](int v) {
+    while (fragment[v] != v) {
+      fragment[v] = fragment[fragment[v]];
+      v = fragment[v];
+    }
+    return v;
+  };
+  auto degree = [&link](int v) { return (link[2 * v] >= 0) + (link[2 * v + 1] >= 0); };
+  auto attach = [&link](int v, int w) { link[2 * v + (link[2 * v] >= 0)] = w; };
+
+  for (const auto& e : edges) {
+    if (degree(e.a) == 2 || degree(e.b) == 2) continue;
+    const int fa = find(e.a), fb = find(e.b);
+    if (fa == fb) continue;
+    fragment[fb] = fa;
+    attach(e.a, e.b);
+    attach(e.b, e.a);
+  }
+
+  // Walk each fragment from one of its endpoints (isolated nodes count as
+  // fragments of length one) and concatenate along the Hilbert curve.
+  std::pmr::vector<char> visited(n, 0, memory);
+  std::pmr::vector<int> order(n, memory);
+  hilbertOrder(points, order.data(), memory);
+  int length = 0;
+  for (int start : order) {
+    if (visited[start] || degree(start) == 2) continue;
+    int prev = -1, v = start;
+    while (v >= 0) {
+      visited[v] = 1;
+      tour[length++] = v;
+      const int next = link[2 * v] != prev ? link[2 * v] : link[2 * v + 1];
+      prev = v;
+      v = next >= 0 && !visited[next] ? next : -1;
+    }
+  }
+}
+
+template <typename Metric>
+LocalSearch<Metric>::LocalSearch(const Metric& metric,
+                                 const std::vector<int>& neighbors, size_t k,
+                                 const LocalSearchConfig& config)
+    : LocalSearch(metric, neighbors.data(), k, config) {}
+
+template <typename Metric>
+LocalSearch<Metric>::LocalSearch(const Metric& metric, const int* neighbors, size_t k,
+                                 const LocalSearchConfig& config,
+                                 std::pmr::memory_resource* memory)
+    : metric_(metric), neighbors_(neighbors), k_(k), config_(config),
+      pos_(memory), queue_(memory), queued_(memory) {}
+
+template <typename Metric>
+void LocalSearch<Metric>::push(int v) {
+  if (!queued_[v]) {
+    queued_[v] = 1;
+    queue_.push_back(v);
+  }
+}
+
+template <typename Metric>
+void LocalSearch<Metric>::improve(std::vector<int>& tour, const std::vector<int>& active) {
+  improve(tour.data(), static_cast<int>(tour.size()), active);
+}
+
+template <typename Metric>
+void LocalSearch<Metric>::improve(int* tour, int n, const std::vector<int>& active) {
+  n_ = n;
+  if (n_ < 5) {
+    return;
+  }
+
+  tour_ = tour;
+  pos_.resize(n_);
+  for (int i = 0; i < n_; ++i) {
+    pos_[tour_[i]] = i;
+  }
+
+  queue_.clear();
+  queue_.reserve(2 * n_ + 1);
+  queued_.assign(n_, 0);
+  head_ = 0;
+  if (active.empty()) {
+    for (int i = 0; i < n_; ++i) push(tour_[i]);
+  } else {
+    for (int v : active) push(v);
+  }
+
+  while (head_ < queue_.size()) {
+    const int a = queue_[head_++];
+    queued_[a] = 0;
+    if (tryTwoOpt(a) || tryOrOpt(a)) {
+      push(a);
+    }
+    // Compact the consumed prefix so the queue stays O(n).
+    if (head_ > static_cast<size_t>(n_)) {
+      queue_.erase(queue_.begin(), queue_.begin() + head_);
+      head_ = 0;
+    }
+  }
+
+  tour_ = nullptr;
+}
+
+// Reverses the tour path running forward from node `from` to node `to`. The
+// complementary path is reversed instead when it is shorter; both give the
+// same cycle.
+template <typename Metric>
+void LocalSearch<Metric>::reversePath(int from, int to) {
+  int i = pos_[from];
+  int j = pos_[to];
+  int len = (j - i + n_) % n_ + 1;
+  if (2 * len > n_) {
+    i = j + 1 == n_ ? 0 : j + 1;
+    j = pos_[from] == 0 ? n_ - 1 : pos_[from] - 1;
+    len = n_ - len;
+  }
+
+  for (int s = 0; s < len / 2; ++s) {
+    std::swap(tour_[i], tour_[j]);
+    pos_[tour_[i]] = i;
+    pos_[tour_[j]] = j;
+    i = i + 1 == n_ ? 0 : i + 1;
+    j = j == 0 ? n_ - 1 : j - 1;
+  }
+}
+
+// Replaces edges (a,b) and (c,d) with (a,c) and (b,d). Both edges must run
+// in the same direction, either b = next(a), d = next(c) or the mirror.
+template <typename Metric>
+void LocalSearch<Metric>::twoOptMove(int a, int b, int c, int d) {
+  if (next(a) != b) {
+    std::swap(a, b);
+    std::swap(c, d);
+  }
+  reversePath(b, c);
+}
+
+template <typename Metric>
+bool LocalSearch<Metric>::tryTwoOpt(int a) {
+  const int* candidates = &neighbors_[a * k_];
+
+  for (int direction = 0; direction < 2; ++direction) {
+    const int b = direction == 0 ? next(a) : prev(a);
+    const value_type ab = dist(a, b);
+
+    for (size_t i = 0; i < k_; ++i) {
+      const int c = candidates[i];
+      if (c < 0) break;
+      const value_type ac = dist(a, c);
+      // Candidates are sorted, so no later c can shorten the (a,b) edge.
+      if (ac >= ab - kEpsilon) break;
+
+      const int d = direction == 0 ? next(c) : prev(c);
+      if (c == b || d == a) continue;
+
+      const value_type delta = ac + dist(b, d) - ab - dist(c, d);
+      if (delta < -kEpsilon) {
+        twoOptMove(a, b, c, d);
+        push(b);
+        push(c);
+        push(d);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+template <typename Metric>
+bool LocalSearch<Metric>::tryOrOpt(int a) {
+  const int maxLength = std::min<int>(config_.maxSegmentLength, n_ - 3);
+
+  int s2 = a;
+  for (int length = 1; length <= maxLength; ++length, s2 = next(s2)) {
+    const int s1 = a;
+    const int x = prev(s1);
+    const int y = next(s2);
+    const value_type removeGain = dist(x, s1) + dist(s2, y) - dist(x, y);
+    if (removeGain <= kEpsilon) continue;
+
+    const int start = pos_[s1];
+    auto inSegment = [&](int v) { return (pos_[v] - start + n_) % n_ < length; };
+
+    for (int endpoint : {s1, s2}) {
+      const int* candidates = &neighbors_[endpoint * k_];
+      for (size_t i = 0; i < k_; ++i) {
+        const int c = candidates[i];
+        if (c < 0) break;
+        if (dist(endpoint, c) >= removeGain - kEpsilon) break;
+        if (inSegment(c)) continue;
+
+        // Try inserting between c and either tour neighbour.
+        for (int side = 0; side < 2; ++side) {
+          const int p = side == 0 ? c : prev(c);
+          const int q = side == 0 ? next(c) : c;
+          if (inSegment(p) || inSegment(q)) continue;
+
+          const value_type pq = dist(p, q);
+          const value_type forward = dist(p, s1) + dist(s2, q) - pq;
+          const value_type reversed = dist(p, s2) + dist(s1, q) - pq;
+          const value_type delta = std::min(forward, reversed) - removeGain;
+          if (delta >= -kEpsilon) continue;
+
+          // Segment insertion as a sequence of 2-opt moves:
+          //   x s1..s2 y .. p q  ->  x p .. y s2..s1 q  ->  x y .. p s2..s1 q
+          // and one more reversal when the forward orientation is cheaper.
+          twoOptMove(x, s1, p, q);
+          twoOptMove(x, p, y, s2);
+          if (forward < reversed) {
+            twoOptMove(p, s2, s1, q);
+          }
+
+          push(x);
+          push(y);
+          push(p);
+          push(q);
+          push(s2);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+LocalSearchOptimizer::LocalSearchOptimizer(const LocalSearchConfig& config)
+    : config_(config) {}
+
+template <typename Metric>
+Route LocalSearchOptimizer::solve(const Metric& metric) {
+  SolverWorkspace& workspace = beginSolve();
+  const PointVector& points = metric.points();
+  Route result;
+  result.path.resize(points.size());
+
+  if (points.size() > 4) {
+    const size_t k = std::min(config_.candidateNeighbors, points.size() - 1);
+    int* neighbors = workspace.allocate<int>(points.size() * k);
+    SpatialGrid(points, 2, workspace.resource()).nearestNeighbors(k, neighbors);
+    sortCandidates(metric, neighbors, points.size(), k);
+    greedyTour(metric, neighbors, k, result.path.data(), workspace.resource());
+    LocalSearch(metric, neighbors, k, config_, workspace.resource()).improve(result.path);
+  } else {
+    hilbertOrder(points, result.path.data(), workspace.resource());
+  }
+
+  result.totalDistance = utils::tourLength(metric, result.path);
+  return result;
+}
+
+Route LocalSearchOptimizer::findOptimalRoute(const PointVector& points) {
+  switch (config_.metric) {
+    case MetricKind::Euclidean:
+      return solve(EuclideanMetric(points));
+    case MetricKind::RoundedEuclidean:
+      return solve(RoundedEuclideanMetric(points));
+    case MetricKind::Manhattan:
+      return solve(ManhattanMetric(points));
+    case MetricKind::Geographic:
+      return solve(GeoMetric(points));
+    case MetricKind::Matrix:
+      break;
+  }
+  throw std::invalid_argument("Matrix metric requires findOptimalRouteForMatrix");
+}
+
+template <typename Metric>
+std::vector<int> LocalSearchOptimizer::solveMatrix(const Metric& metric) {
+  SolverWorkspace& workspace = beginSolve();
+  AsymmetricLocalSearch search(metric, config_.candidateNeighbors,
+                               config_.maxSegmentLength, workspace.resource());
+  std::vector<int> tour = search.nearestNeighborTour();
+  search.improve(tour);
+  return tour;
+}
+
+Route LocalSearchOptimizer::findOptimalRouteForMatrix(
+    const std::vector<std::vector<double>>& distances) {
+  if (!utils::isValidDistanceMatrix(distances)) {
+    throw std::invalid_argument("Invalid distance matrix");
+  }
+
+  Route result;
+  if (config_.precision == DistancePrecision::Double) {
+    result.path = solveMatrix(MatrixMetric(distances));
+  } else {
+    result = findOptimalRouteForMatrix(QuantizedMatrix(distances, config_.precision));
+  }
+  result.totalDistance = utils::tourLength(distances, result.path);
+  return result;
+}
+
+Route LocalSearchOptimizer::findOptimalRouteForMatrix(const QuantizedMatrix& distances) {
+  Route result;
+  if (distances.precision() == DistancePrecision::Int32) {
+    result.path = solveMatrix(Int32MatrixMetric(distances));
+  } else {
+    result.path = solveMatrix(UInt16MatrixMetric(distances));
+  }
+
+  result.totalDistance = 0.0;
+  for (size_t i = 0; i < result.path.size(); ++i) {
+    result.totalDistance +=
+        distances.distance(result.path[i], result.path[(i + 1) % result.path.size()]);
+  }
+  return result;
+}
+
+template class LocalSearch<EuclideanMetric>;
+template class LocalSearch<RoundedEuclideanMetric>;
+template class LocalSearch<ManhattanMetric>;
+template class LocalSearch<GeoMetric>;
+
+template void greedyTour(const EuclideanMetric&, const int*, size_t, int*,
+                         std::pmr::memory_resource*);
+template void greedyTour(const RoundedEuclideanMetric&, const int*, size_t, int*,
+                         std::pmr::memory_resource*);
+template void greedyTour(const ManhattanMetric&, const int*, size_t, int*,
+                         std::pmr::memory_resource*);
+template void greedyTour(const GeoMetric&, const int*, size_t, int*,
+                         std::pmr::memory_resource*);
+
+namespace utils {
+double tourLength(const PointVector& points, const std::vector<int>& tour) {
+  double total = 0.0;
+  for (size_t i = 0; i < tour.size(); ++i) {
+    total += points[tour[i]].distanceTo(points[tour[(i + 1) % tour.size()]]);
+  }
+  return total;
+}
+
+double tourLength(const std::vector<std::vector<double>>& distances,
+                  const std::vector<int>& tour) {
+  double total = 0.0;
+  for (size_t i = 0; i < tour.size(); ++i) {
+    total += distances[tour[i]][tour[(i + 1) % tour.size()]];
+  }
+  return total;
+}
+}; // namespace utils
+
+}; // namespace route_opt
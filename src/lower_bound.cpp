@@ -0,0 +1,279 @@
+#include "lower_bound.h"
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace route_opt {
+
+namespace {
+
+struct DisjointSets {
+  std::vector<int> parent;
+
+  explicit DisjointSets(size_t n) : parent(n) {
+    std::iota(parent.begin(), parent.end(), 0);
+  }
+
+  int find(int v) {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  }
+
+  bool unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return false;
+    parent[b] = a;
+    return true;
+  }
+};
+
+} // namespace
+
+HeldKarpBound::HeldKarpBound(const LowerBoundConfig& config) : config_(config) {}
+
+std::vector<HeldKarpBound::Edge>
+HeldKarpBound::candidateEdges(const PointVector& points) const {
+  const size_t n = points.size();
+  const size_t k = std::min(config_.candidateNeighbors, n - 1);
+  const SpatialGrid grid(points);
+  const auto neighbors = grid.nearestNeighbors(k);
+
+  std::vector<Edge> edges;
+  edges.reserve(n * k);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t a = 0; a < k; ++a) {
+      const int j = neighbors[i * k + a];
+      if (j < 0) continue;
+      // Keep (i, j) once: from the lower index, or from i when j does not
+      // list i back.
+      const int* row = &neighbors[j * k];
+      const bool mutual = std::find(row, row + k, int(i)) != row + k;
+      if (size_t(j) > i || !mutual) {
+        edges.push_back({int(i), j, points[i].distanceTo(points[j])});
+      }
+    }
+  }
+
+  // Clustered inputs can leave the candidate graph disconnected, in which
+  // case no spanning tree exists. Boruvka rounds join the components of the
+  // nodes other than 0: each component gains the shortest edge to another
+  // one, found by grid searches bounded by the best bridge so far.
+  std::vector<int> labels(n);
+  std::vector<Edge> bridges(n);
+  while (true) {
+    DisjointSets sets(n);
+    for (const auto& e : edges) {
+      if (e.from != 0 && e.to != 0) sets.unite(e.from, e.to);
+    }
+
+    size_t components = 0;
+    labels[0] = -1;
+    for (size_t v = 1; v < n; ++v) {
+      labels[v] = sets.find(v);
+      if (labels[v] == int(v)) ++components;
+    }
+    if (components <= 1) break;
+
+    std::fill(bridges.begin(), bridges.end(),
+              Edge{-1, -1, std::numeric_limits<double>::infinity()});
+    for (size_t v = 1; v < n; ++v) {
+      Edge& bridge = bridges[labels[v]];
+      const int j = grid.nearestOutside(points[v], labels.data(), labels[v], bridge.length);
+      if (j >= 0) {
+        bridge = {int(v), j, points[v].distanceTo(points[j])};
+      }
+    }
+    for (const auto& bridge : bridges) {
+      if (bridge.from >= 0) edges.push_back(bridge);
+    }
+  }
+
+  return edges;
+}
+
+double HeldKarpBound::sparseOneTree(const std::vector<Edge>& edges, size_t n,
+                                    const std::vector<double>& penalties,
+                                    std::vector<int>& degrees) const {
+  std::vector<double> cost(edges.size());
+  std::vector<int> order;
+  order.reserve(edges.size());
+
+  // Node 0 is the special node of the 1-tree: the spanning tree covers the
+  // remaining nodes and node 0 contributes its two cheapest edges.
+  double first = std::numeric_limits<double>::infinity(), second = first;
+  int firstEdge = -1, secondEdge = -1;
+  for (size_t e = 0; e < edges.size(); ++e) {
+    cost[e] = edges[e].length + penalties[edges[e].from] + penalties[edges[e].to];
+    if (edges[e].from != 0 && edges[e].to != 0) {
+      order.push_back(e);
+    } else if (cost[e] < first) {
+      second = first;
+      secondEdge = firstEdge;
+      first = cost[e];
+      firstEdge = e;
+    } else if (cost[e] < second) {
+      second = cost[e];
+      secondEdge = e;
+    }
+  }
+  std::sort(order.begin(), order.end(),
+            [&cost](int a, int b) { return cost[a] < cost[b]; });
+
+  std::fill(degrees.begin(), degrees.end(), 0);
+  double length = 0.0;
+  size_t treeEdges = 0;
+  DisjointSets sets(n);
+  for (int e : order) {
+    if (sets.unite(edges[e].from, edges[e].to)) {
+      length += cost[e];
+      ++degrees[edges[e].from];
+      ++degrees[edges[e].to];
+      if (++treeEdges == n - 2) break;
+    }
+  }
+
+  for (int e : {firstEdge, secondEdge}) {
+    if (e < 0) continue;
+    length += cost[e];
+    ++degrees[edges[e].from];
+    ++degrees[edges[e].to];
+  }
+
+  return length - 2.0 * std::accumulate(penalties.begin(), penalties.end(), 0.0);
+}
+
+double HeldKarpBound::denseOneTree(const PointVector& points,
+                                   const std::vector<double>& penalties) const {
+  const long n = static_cast<long>(points.size());
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // Prim's algorithm over nodes 1..n-1 with distances computed on the fly,
+  // so memory stays O(n).
+  std::vector<double> key(n, inf);
+  std::vector<char> inTree(n, 0);
+  inTree[0] = 1;
+  key[1] = 0.0;
+  double length = 0.0;
+
+  for (long added = 0; added < n - 1; ++added) {
+    long u = -1;
+    for (long v = 1; v < n; ++v) {
+      if (!inTree[v] && (u < 0 || key[v] < key[u])) u = v;
+    }
+    inTree[u] = 1;
+    length += key[u];
+
+#pragma omp parallel for
+    for (long v = 1; v < n; ++v) {
+      if (inTree[v]) continue;
+      const double c = points[u].distanceTo(points[v]) + penalties[u] + penalties[v];
+      if (c < key[v]) key[v] = c;
+    }
+  }
+
+  double first = inf, second = inf;
+  for (long v = 1; v < n; ++v) {
+    const double c = points[0].distanceTo(points[v]) + penalties[0] + penalties[v];
+    if (c < first) {
+      second = first;
+      first = c;
+    } else if (c < second) {
+      second = c;
+    }
+  }
+  length += first + second;
+
+  return length - 2.0 * std::accumulate(penalties.begin(), penalties.end(), 0.0);
+}
+
+LowerBoundResult HeldKarpBound::compute(const PointVector& points,
+                                        double upperBound) const {
+  const size_t n = points.size();
+  LowerBoundResult result;
+  result.penalties.assign(n, 0.0);
+
+  if (n < 3) {
+    result.bound = n == 2 ? 2.0 * points[0].distanceTo(points[1]) : 0.0;
+    result.certified = true;
+    return result;
+  }
+
+  const auto edges = candidateEdges(points);
+  std::vector<double> penalties(n, 0.0);
+  std::vector<int> degrees(n, 0);
+
+  double best = -std::numeric_limits<double>::infinity();
+  double target = upperBound;
+  double step = config_.initialStep;
+  size_t stall = 0;
+
+  for (size_t it = 0; it < config_.maxIterations; ++it) {
+    const double w = sparseOneTree(edges, n, penalties, degrees);
+    result.iterations = it + 1;
+
+    if (it == 0 && target <= 0.0) {
+      target = 1.1 * w;
+    }
+
+    if (w > best) {
+      best = w;
+      result.penalties = penalties;
+      stall = 0;
+    } else if (++stall >= config_.stallIterations) {
+      step *= 0.5;
+      stall = 0;
+    }
+
+    double norm = 0.0;
+    for (size_t v = 0; v < n; ++v) {
+      norm += double(degrees[v] - 2) * double(degrees[v] - 2);
+    }
+    // Every node has degree 2: the 1-tree is a tour and the bound is tight.
+    if (norm == 0.0) {
+      best = w;
+      result.penalties = penalties;
+      break;
+    }
+    if (config_.targetGap > 0.0 && upperBound > 0.0 &&
+        optimalityGap(upperBound, best) <= config_.targetGap) {
+      break;
+    }
+    if (step < 1e-6) break;
+
+    // The sparse 1-tree may exceed an estimated target; keep the step positive.
+    const double t = step * (std::max(target, w * 1.001) - w) / norm;
+    for (size_t v = 0; v < n; ++v) {
+      penalties[v] += t * (degrees[v] - 2);
+    }
+  }
+
+  result.bound = best;
+  if (n <= config_.certifyLimit) {
+    // A 1-tree restricted to candidate edges can be longer than the true
+    // minimum 1-tree, so only the complete-graph value is a valid bound.
+    result.bound = denseOneTree(points, result.penalties);
+    result.certified = true;
+  }
+
+  return result;
+}
+
+double certifiedLowerBound(const PointVector& points) {
+  const LowerBoundResult result = HeldKarpBound().compute(points);
+  return result.certified ? result.bound : 0.0;
+}
+
+double optimalityGap(double tourLength, double lowerBound) {
+  if (lowerBound <= 0.0) {
+    return tourLength > 0.0 ? std::numeric_limits<double>::infinity() : 0.0;
+  }
+  return (tourLength - lowerBound) / lowerBound;
+}
+
+}; // namespace route_opt
@@ -0,0 +1,475 @@
+#include "memetic.h"
+#include "checkpoint.h"
+#include "local_search.h"
+#include "lower_bound.h"
+#include "spatial_index.h"
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Island state. Tours are rows of the shared arena: member_ maps population
+// slots to rows and childRow_ is scratch for the next offspring. Rows pinned
+// by a pending checkpoint are never written, so the arena needs a spare row
+// per member while checkpointing.
+class Island {
+public:
+  Island(const PointVector& points, const std::vector<int>& neighbors, size_t k,
+         int* rows, size_t rowCount, double* lengths, size_t size, unsigned int seed)
+      : points_(points), neighbors_(neighbors), k_(k),
+        n_(static_cast<int>(points.size())), search_(EuclideanMetric(points), neighbors, k),
+        rng_(seed), rows_(rows), lengths_(lengths), size_(size), member_(size),
+        used_(rowCount), pinned_(rowCount), childRow_(static_cast<int>(size)),
+        succ_(2 * n_), pred_(2 * n_), visited_(n_), free_(n_), slot_(n_) {
+    for (size_t i = 0; i < size_; ++i) {
+      member_[i] = static_cast<int>(i);
+      used_[i] = 1;
+    }
+  }
+
+  // Fills the population with randomised nearest-neighbour tours after
+  // local search. With `seeded` the first member starts from the greedy tour.
+  void initialize(bool seeded) {
+    for (size_t i = 0; i < size_; ++i) {
+      if (seeded && i == 0) {
+        const auto greedy = greedyTour(points_, neighbors_, k_);
+        std::copy(greedy.begin(), greedy.end(), tour(i));
+      } else {
+        construct(nullptr, nullptr, tour(i));
+      }
+      search_.improve(tour(i), n_);
+      lengths_[i] = length(tour(i));
+    }
+  }
+
+  // One generation: two random parents produce a child that replaces the
+  // worst member when it is better and not a duplicate.
+  void generation() {
+    std::uniform_int_distribution<size_t> pick(0, size_ - 1);
+    const size_t a = pick(rng_);
+    size_t b = pick(rng_);
+    while (size_ > 1 && b == a) b = pick(rng_);
+
+    active_.clear();
+    construct(tour(a), tour(b), child());
+    if (active_.empty()) {
+      doubleBridge(child());
+    }
+    search_.improve(child(), n_, active_);
+    offer(child(), length(child()));
+    ++generations_;
+  }
+
+  size_t best() const {
+    return std::min_element(lengths_, lengths_ + size_) - lengths_;
+  }
+
+  // Replaces the worst member with `candidate` if it improves on it and no
+  // member has the same length.
+  bool offer(const int* candidate, double length) {
+    const size_t worst = std::max_element(lengths_, lengths_ + size_) - lengths_;
+    if (length >= lengths_[worst] - 1e-9) return false;
+    for (size_t i = 0; i < size_; ++i) {
+      if (std::abs(lengths_[i] - length) <= 1e-9 * length) return false;
+    }
+    if (candidate != child()) {
+      std::copy(candidate, candidate + n_, child());
+    }
+    used_[member_[worst]] = 0;
+    used_[childRow_] = 1;
+    member_[worst] = childRow_;
+    lengths_[worst] = length;
+    childRow_ = 0;
+    while (used_[childRow_] || pinned_[childRow_]) ++childRow_;
+    return true;
+  }
+
+  // Keeps the current members' rows unchanged until release().
+  void pin() {
+    for (int row : member_) pinned_[row] = 1;
+  }
+  void release() { std::fill(pinned_.begin(), pinned_.end(), 0); }
+
+  int* tour(size_t i) { return rows_ + static_cast<size_t>(member_[i]) * n_; }
+  double lengthOf(size_t i) const { return lengths_[i]; }
+
+  std::mt19937& rng() { return rng_; }
+  uint64_t& generations() { return generations_; }
+
+private:
+  const PointVector& points_;
+  const std::vector<int>& neighbors_;
+  const size_t k_;
+  const int n_;
+  LocalSearch<EuclideanMetric> search_;
+  std::mt19937 rng_;
+
+  int* rows_;
+  double* lengths_;
+  const size_t size_;
+  std::vector<int> member_;
+  std::vector<char> used_;
+  std::vector<char> pinned_;
+  int childRow_;
+  uint64_t generations_ = 0;
+  // succ_/pred_ hold both parents: entries [0, n) for the first, [n, 2n)
+  // for the second.
+  std::vector<int> succ_;
+  std::vector<int> pred_;
+  std::vector<char> visited_;
+  std::vector<int> free_;
+  std::vector<int> slot_;
+  size_t freeCount_ = 0;
+  std::vector<int> active_;
+
+  int* child() { return rows_ + static_cast<size_t>(childRow_) * n_; }
+
+  double dist(int a, int b) const { return points_[a].distanceTo(points_[b]); }
+
+  double length(const int* t) const {
+    double total = dist(t[n_ - 1], t[0]);
+    for (int i = 1; i < n_; ++i) total += dist(t[i - 1], t[i]);
+    return total;
+  }
+
+  bool inParent(int p, int u, int v) const {
+    return succ_[p * n_ + u] == v || pred_[p * n_ + u] == v;
+  }
+
+  void visit(int v) {
+    visited_[v] = 1;
+    const int last = free_[--freeCount_];
+    free_[slot_[v]] = last;
+    slot_[last] = slot_[v];
+  }
+
+  // Nearest unvisited node among the candidate list, or among a few of the
+  // remaining free nodes when every candidate is taken.
+  int nearestFree(int v, bool randomize) {
+    const int* candidates = &neighbors_[v * k_];
+    int choice[3];
+    int found = 0;
+    for (size_t i = 0; i < k_ && found < (randomize ? 3 : 1); ++i) {
+      const int c = candidates[i];
+      if (c < 0) break;
+      if (!visited_[c]) choice[found++] = c;
+    }
+    if (found > 0) {
+      return randomize ? choice[std::uniform_int_distribution<int>(0, found - 1)(rng_)] : choice[0];
+    }
+
+    int best = free_[freeCount_ - 1];
+    const size_t sample = std::min<size_t>(freeCount_, 16);
+    for (size_t i = 1; i < sample; ++i) {
+      const int c = free_[freeCount_ - 1 - i];
+      if (dist(v, c) < dist(v, best)) best = c;
+    }
+    return best;
+  }
+
+  // Edge recombination. From a random start the walk follows, in order of
+  // preference, an edge shared by both parents, the shorter unused parent
+  // edge, or the nearest unvisited candidate neighbour. Without parents it
+  // is a randomised nearest-neighbour tour. Endpoints of edges that are not
+  // common to both parents are collected in active_.
+  void construct(const int* first, const int* second, int* out) {
+    const bool parents = first != nullptr;
+    if (parents) {
+      const int* parent[2] = {first, second};
+      for (int p = 0; p < 2; ++p) {
+        for (int i = 0; i < n_; ++i) {
+          const int v = parent[p][i];
+          succ_[p * n_ + v] = parent[p][i + 1 == n_ ? 0 : i + 1];
+          pred_[p * n_ + v] = parent[p][i == 0 ? n_ - 1 : i - 1];
+        }
+      }
+    }
+
+    std::fill(visited_.begin(), visited_.end(), 0);
+    for (int v = 0; v < n_; ++v) {
+      free_[v] = v;
+      slot_[v] = v;
+    }
+    freeCount_ = n_;
+
+    int current = std::uniform_int_distribution<int>(0, n_ - 1)(rng_);
+    visit(current);
+    out[0] = current;
+
+    for (int i = 1; i < n_; ++i) {
+      int next = -1;
+      bool inherited = false;
+      if (parents) {
+        const int options[4] = {succ_[current], pred_[current],
+                                succ_[n_ + current], pred_[n_ + current]};
+        for (int c : options) {
+          if (visited_[c]) continue;
+          if (inParent(0, current, c) && inParent(1, current, c)) {
+            next = c;
+            break;
+          }
+          if (next < 0 || dist(current, c) < dist(current, next)) next = c;
+        }
+        inherited = next >= 0;
+      }
+      if (next < 0) {
+        next = nearestFree(current, !parents);
+      }
+
+      if (parents && !(inherited && inParent(0, current, next) && inParent(1, current, next))) {
+        active_.push_back(current);
+        active_.push_back(next);
+      }
+      visit(next);
+      out[i] = next;
+      current = next;
+    }
+
+    if (parents && !(inParent(0, current, out[0]) && inParent(1, current, out[0]))) {
+      active_.push_back(current);
+      active_.push_back(out[0]);
+    }
+  }
+
+  // Random double-bridge kick for children that repeat their parents'
+  // edges exactly; the eight cut endpoints are handed to the local search.
+  void doubleBridge(int* t) {
+    if (n_ < 8) return;
+    std::uniform_int_distribution<int> cut(1, n_ - 1);
+    int p[3];
+    do {
+      p[0] = cut(rng_);
+      p[1] = cut(rng_);
+      p[2] = cut(rng_);
+      std::sort(p, p + 3);
+    } while (p[0] == p[1] || p[1] == p[2]);
+
+    // A B C D -> A C B D
+    std::rotate(t + p[0], t + p[1], t + p[2]);
+    for (int c : {0, p[0], p[2]}) {
+      active_.push_back(t[c]);
+      active_.push_back(t[c == 0 ? n_ - 1 : c - 1]);
+    }
+    active_.push_back(t[p[0] + p[2] - p[1] - 1]);
+    active_.push_back(t[p[0] + p[2] - p[1]]);
+  }
+};
+
+constexpr char kCheckpointTag[] = "memetic";
+
+// Checkpoint of all islands between two migrations. Tours point into rows
+// the islands keep pinned until done(); everything else is copied.
+struct PopulationSnapshot : Snapshot {
+  // Instance fingerprint and the settings that shape the search; a resumed
+  // run must match all of them.
+  std::vector<uint64_t> key;
+  uint64_t epochs = 0;
+  uint64_t stalled = 0;
+  double best = 0.0;
+  double elapsed = 0.0;
+  size_t n = 0;
+  std::vector<uint64_t> generations;
+  std::vector<std::mt19937> rngs;
+  std::vector<double> lengths;
+  std::vector<const int*> tours;
+
+  void encode(BinaryWriter& out) const override {
+    out.writeString(kCheckpointTag);
+    out.write(key.data(), key.size());
+    out.write(epochs);
+    out.write(stalled);
+    out.write(best);
+    out.write(elapsed);
+    const size_t size = lengths.size() / rngs.size();
+    for (size_t i = 0; i < rngs.size(); ++i) {
+      std::ostringstream rng;
+      rng << rngs[i];
+      out.write(generations[i]);
+      out.writeString(rng.str());
+      out.write(lengths.data() + i * size, size);
+      for (size_t j = 0; j < size; ++j) out.write(tours[i * size + j], n);
+    }
+  }
+};
+} // namespace
+
+MemeticOptimizer::MemeticOptimizer(const MemeticConfig& config) : config_(config) {
+  config_.populationSize = std::max<size_t>(config_.populationSize, 2);
+  config_.migrationInterval = std::max<size_t>(config_.migrationInterval, 1);
+}
+
+Route MemeticOptimizer::findOptimalRoute(const PointVector& points) {
+  const auto start = Clock::now();
+  auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double>(config_.timeLimit));
+  const int n = static_cast<int>(points.size());
+
+  if (n < 8) {
+    return LocalSearchOptimizer().findOptimalRoute(points);
+  }
+
+  const size_t k = std::min<size_t>(config_.candidateNeighbors, n - 1);
+  const auto neighbors = SpatialGrid(points).nearestNeighbors(k);
+
+  const size_t islandCount = config_.islands > 0 ? config_.islands : omp_get_max_threads();
+  const size_t size = config_.populationSize;
+  const bool checkpointing = !config_.checkpointPath.empty();
+  const size_t rowCount = (checkpointing ? 2 * size : size) + 1;
+  std::vector<int> arena(islandCount * rowCount * n);
+  std::vector<double> lengths(islandCount * size);
+
+  std::vector<Island> islands;
+  islands.reserve(islandCount);
+  for (size_t i = 0; i < islandCount; ++i) {
+    islands.emplace_back(points, neighbors, k, arena.data() + i * rowCount * n, rowCount,
+                         lengths.data() + i * size, size,
+                         config_.seed + static_cast<unsigned int>(i));
+  }
+
+  const double lowerBound = gapTolerance_ > 0.0 ? certifiedLowerBound(points) : 0.0;
+
+  auto bestLength = [&]() {
+    double best = lengths[0];
+    for (double l : lengths) best = std::min(best, l);
+    return best;
+  };
+
+  const std::vector<uint64_t> key = {fingerprint(points), islandCount, size,
+                                     config_.migrationInterval, k, config_.seed};
+  uint64_t epochs = 0;
+  uint64_t stalled = 0;
+  double best = 0.0;
+  double elapsedBefore = 0.0;
+
+  if (!config_.resumePath.empty()) {
+    const auto payload = readCheckpoint(config_.resumePath);
+    BinaryReader in(payload);
+    if (in.readString() != kCheckpointTag) {
+      throw std::runtime_error("Not a memetic checkpoint: " + config_.resumePath);
+    }
+    std::vector<uint64_t> saved(key.size());
+    in.read(saved.data(), saved.size());
+    if (saved != key) {
+      throw std::runtime_error("Checkpoint " + config_.resumePath +
+                               " was saved for a different instance or configuration");
+    }
+    epochs = in.read<uint64_t>();
+    stalled = in.read<uint64_t>();
+    best = in.read<double>();
+    elapsedBefore = in.read<double>();
+    for (size_t i = 0; i < islandCount; ++i) {
+      islands[i].generations() = in.read<uint64_t>();
+      std::istringstream rng(in.readString());
+      rng >> islands[i].rng();
+      if (!rng) {
+        throw std::runtime_error("Corrupt checkpoint: " + config_.resumePath);
+      }
+      in.read(lengths.data() + i * size, size);
+      for (size_t j = 0; j < size; ++j) in.read(islands[i].tour(j), n);
+    }
+    if (!in.atEnd()) {
+      throw std::runtime_error("Corrupt checkpoint: " + config_.resumePath);
+    }
+    deadline -= std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(elapsedBefore));
+  } else {
+#pragma omp parallel for num_threads(islandCount) schedule(static, 1)
+    for (size_t i = 0; i < islandCount; ++i) {
+      islands[i].initialize(i == 0);
+    }
+    best = bestLength();
+  }
+
+  std::vector<int> migrants(islandCount * n);
+  std::vector<double> migrantLengths(islandCount);
+
+  // Declared after the arena so that it finishes writing before the rows
+  // its snapshot points at go away.
+  std::unique_ptr<CheckpointWriter> writer;
+  std::shared_ptr<PopulationSnapshot> pending;
+  const auto checkpointInterval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(config_.checkpointInterval));
+  auto nextCheckpoint = start + checkpointInterval;
+  if (checkpointing) {
+    writer = std::make_unique<CheckpointWriter>(config_.checkpointPath);
+  }
+
+  while (Clock::now() < deadline) {
+    if (lowerBound > 0.0 && optimalityGap(best, lowerBound) <= gapTolerance_) break;
+
+    // Only complete epochs reach this point, so a run resumed from here
+    // replays exactly the generations that follow.
+    if (pending && pending->done()) {
+      for (auto& island : islands) island.release();
+      pending.reset();
+    }
+    if (writer && !pending && Clock::now() >= nextCheckpoint) {
+      auto snapshot = std::make_shared<PopulationSnapshot>();
+      snapshot->key = key;
+      snapshot->epochs = epochs;
+      snapshot->stalled = stalled;
+      snapshot->best = best;
+      snapshot->elapsed = elapsedBefore + std::chrono::duration<double>(Clock::now() - start).count();
+      snapshot->n = n;
+      snapshot->lengths = lengths;
+      for (auto& island : islands) {
+        island.pin();
+        snapshot->generations.push_back(island.generations());
+        snapshot->rngs.push_back(island.rng());
+        for (size_t j = 0; j < size; ++j) snapshot->tours.push_back(island.tour(j));
+      }
+      if (writer->submit(snapshot)) {
+        pending = std::move(snapshot);
+      } else {
+        for (auto& island : islands) island.release();
+      }
+      nextCheckpoint = Clock::now() + checkpointInterval;
+    }
+
+#pragma omp parallel for num_threads(islandCount) schedule(static, 1)
+    for (size_t i = 0; i < islandCount; ++i) {
+      for (size_t g = 0; g < config_.migrationInterval && Clock::now() < deadline; ++g) {
+        islands[i].generation();
+      }
+    }
+    ++epochs;
+
+    // Ring migration: every island sends a copy of its best tour to the next.
+    for (size_t i = 0; i < islandCount; ++i) {
+      const size_t b = islands[i].best();
+      std::copy(islands[i].tour(b), islands[i].tour(b) + n, migrants.begin() + i * n);
+      migrantLengths[i] = islands[i].lengthOf(b);
+    }
+    for (size_t i = 0; i < islandCount && islandCount > 1; ++i) {
+      islands[(i + 1) % islandCount].offer(migrants.data() + i * n, migrantLengths[i]);
+    }
+
+    const double current = bestLength();
+    if (current < best - 1e-9) {
+      best = current;
+      stalled = 0;
+    } else if (config_.stallMigrations > 0 && ++stalled >= config_.stallMigrations) {
+      break;
+    }
+  }
+
+  const size_t winner = std::min_element(lengths.begin(), lengths.end()) - lengths.begin();
+  const int* tour = islands[winner / size].tour(winner % size);
+  Route result;
+  result.path.assign(tour, tour + n);
+  result.totalDistance = utils::tourLength(points, result.path);
+  return result;
+}
+
+}; // namespace route_opt
@@ -0,0 +1,128 @@
+#include "quantized.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace route_opt {
+
+namespace {
+constexpr double kFullScale = double(1 << 30);
+} // namespace
+
+QuantizedMatrix::QuantizedMatrix(const std::vector<std::vector<double>>& distances,
+                                 DistancePrecision precision, double quantum)
+    : n_(distances.size()), precision_(precision), quantum_(quantum) {
+  if (precision == DistancePrecision::Double) {
+    throw std::invalid_argument("QuantizedMatrix needs an integer precision");
+  }
+  if (quantum_ < 0.0 || !std::isfinite(quantum_)) {
+    throw std::invalid_argument("Invalid quantum");
+  }
+
+  double largest = 0.0;
+  for (const auto& row : distances) {
+    if (row.size() != n_) {
+      throw std::invalid_argument("Distance matrix must be square");
+    }
+    for (double d : row) {
+      if (d < 0.0 || !std::isfinite(d)) {
+        throw std::invalid_argument("Distances must be finite and non-negative");
+      }
+      largest = std::max(largest, d);
+    }
+  }
+  if (quantum_ == 0.0) {
+    quantum_ = largest > 0.0 ? largest / kFullScale : 1.0;
+  }
+  if (largest / quantum_ > kFullScale) {
+    throw std::invalid_argument("Quantum too small for 32-bit storage");
+  }
+
+  allocate();
+  // Every entry was checked above, so setRow() cannot throw here.
+#pragma omp parallel for
+  for (size_t a = 0; a < n_; ++a) {
+    setRow(a, distances[a].data());
+  }
+}
+
+QuantizedMatrix::QuantizedMatrix(size_t n, DistancePrecision precision, double quantum)
+    : n_(n), precision_(precision), quantum_(quantum) {
+  if (precision == DistancePrecision::Double) {
+    throw std::invalid_argument("QuantizedMatrix needs an integer precision");
+  }
+  if (!(quantum_ > 0.0) || !std::isfinite(quantum_)) {
+    throw std::invalid_argument("A row-by-row QuantizedMatrix needs a positive quantum");
+  }
+  allocate();
+}
+
+void QuantizedMatrix::allocate() {
+  if (precision_ == DistancePrecision::Int32) {
+    wide_.assign(n_ * n_, 0);
+  } else {
+    narrow_.assign(n_ * n_, 0);
+    shift_.assign(n_, 0);
+  }
+}
+
+void QuantizedMatrix::setRow(size_t a, const double* distances) {
+  if (a >= n_) {
+    throw std::out_of_range("QuantizedMatrix row out of range");
+  }
+  double rowMax = 0.0;
+  for (size_t b = 0; b < n_; ++b) {
+    if (distances[b] < 0.0 || !std::isfinite(distances[b])) {
+      throw std::invalid_argument("Distances must be finite and non-negative");
+    }
+    rowMax = std::max(rowMax, distances[b] / quantum_);
+  }
+  if (rowMax > kFullScale) {
+    throw std::invalid_argument("Quantum too small for 32-bit storage");
+  }
+
+  if (precision_ == DistancePrecision::Int32) {
+    int32_t* row = wide_.data() + a * n_;
+    for (size_t b = 0; b < n_; ++b) {
+      row[b] = static_cast<int32_t>(std::llround(distances[b] / quantum_));
+    }
+    return;
+  }
+
+  // The smallest shift that fits the longest entry in 16 bits.
+  uint8_t shift = 0;
+  while (std::llround(std::ldexp(rowMax, -shift)) > UINT16_MAX) ++shift;
+  shift_[a] = shift;
+  uint16_t* row = narrow_.data() + a * n_;
+  for (size_t b = 0; b < n_; ++b) {
+    row[b] = static_cast<uint16_t>(std::llround(std::ldexp(distances[b] / quantum_, -shift)));
+  }
+}
+
+size_t QuantizedMatrix::bytes() const {
+  return wide_.size() * sizeof(int32_t) + narrow_.size() * sizeof(uint16_t) +
+         shift_.size() * sizeof(uint8_t);
+}
+
+int64_t QuantizedMatrix::quanta(int a, int b) const {
+  if (precision_ == DistancePrecision::Int32) {
+    return wide_[a * n_ + b];
+  }
+  return static_cast<int64_t>(narrow_[a * n_ + b]) << shift_[a];
+}
+
+Int32MatrixMetric::Int32MatrixMetric(const QuantizedMatrix& matrix)
+    : values_(matrix.wide_.data()), n_(matrix.n_) {
+  if (matrix.precision_ != DistancePrecision::Int32) {
+    throw std::invalid_argument("Int32MatrixMetric needs an Int32 matrix");
+  }
+}
+
+UInt16MatrixMetric::UInt16MatrixMetric(const QuantizedMatrix& matrix)
+    : values_(matrix.narrow_.data()), shift_(matrix.shift_.data()), n_(matrix.n_) {
+  if (matrix.precision_ != DistancePrecision::UInt16) {
+    throw std::invalid_argument("UInt16MatrixMetric needs a UInt16 matrix");
+  }
+}
+
+}; // namespace route_opt
@@ -0,0 +1,101 @@
+#include "road_graph.h"
+#include "spatial_index.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace route_opt {
+
+RoadGraph::RoadGraph(PointVector coordinates, const std::vector<Arc>& arcs)
+    : coordinates_(std::move(coordinates)) {
+  const size_t n = coordinates_.size();
+  offsets_.assign(n + 1, 0);
+  for (const auto& arc : arcs) {
+    if (arc.from < 0 || arc.to < 0 || size_t(arc.from) >= n || size_t(arc.to) >= n) {
+      throw std::invalid_argument("Road graph arc refers to a missing node");
+    }
+    if (!(arc.weight >= 0.0) || !std::isfinite(arc.weight)) {
+      throw std::invalid_argument("Road graph arc weights must be finite and non-negative");
+    }
+    ++offsets_[arc.from + 1];
+  }
+  for (size_t v = 0; v < n; ++v) {
+    offsets_[v + 1] += offsets_[v];
+  }
+
+  targets_.resize(arcs.size());
+  weights_.resize(arcs.size());
+  std::vector<int> fill(offsets_.begin(), offsets_.end() - 1);
+  for (const auto& arc : arcs) {
+    const int slot = fill[arc.from]++;
+    targets_[slot] = arc.to;
+    weights_[slot] = arc.weight;
+  }
+}
+
+std::vector<int> RoadGraph::nearestNodes(const PointVector& stops) const {
+  if (coordinates_.empty()) {
+    throw std::invalid_argument("Cannot snap stops to an empty road graph");
+  }
+  const SpatialGrid grid(coordinates_);
+  std::vector<int> nodes(stops.size());
+
+#pragma omp parallel for
+  for (size_t i = 0; i < stops.size(); ++i) {
+    nodes[i] = grid.nearest(stops[i]);
+  }
+  return nodes;
+}
+
+RoadGraph RoadGraph::loadDimacs(const std::string& graphFile, const std::string& coordinateFile) {
+  std::ifstream coordinates(coordinateFile);
+  if (!coordinates) {
+    throw std::runtime_error("Could not open file: " + coordinateFile);
+  }
+
+  PointVector points;
+  std::vector<char> seen;
+  std::string line;
+  while (std::getline(coordinates, line)) {
+    if (line.empty() || line[0] != 'v') continue;
+    std::stringstream ss(line.substr(1));
+    long id;
+    double x, y;
+    if (!(ss >> id >> x >> y) || id < 1) {
+      throw std::runtime_error("Invalid node line in " + coordinateFile + ": " + line);
+    }
+    if (size_t(id) > points.size()) {
+      points.resize(id);
+      seen.resize(id, 0);
+    }
+    points[id - 1] = Point{x, y};
+    seen[id - 1] = 1;
+  }
+  for (char s : seen) {
+    if (!s) throw std::runtime_error("Missing node coordinates in " + coordinateFile);
+  }
+
+  std::ifstream graph(graphFile);
+  if (!graph) {
+    throw std::runtime_error("Could not open file: " + graphFile);
+  }
+
+  std::vector<Arc> arcs;
+  while (std::getline(graph, line)) {
+    if (line.empty() || line[0] != 'a') continue;
+    std::stringstream ss(line.substr(1));
+    long from, to;
+    double weight;
+    if (!(ss >> from >> to >> weight) || from < 1 || to < 1 ||
+        size_t(from) > points.size() || size_t(to) > points.size()) {
+      throw std::runtime_error("Invalid arc line in " + graphFile + ": " + line);
+    }
+    arcs.push_back({static_cast<int>(from - 1), static_cast<int>(to - 1), weight});
+  }
+
+  return RoadGraph(std::move(points), arcs);
+}
+
+}; // namespace route_opt
@@ -1,9 +1,11 @@
 #include "route_generator.h"
+#include "contraction_hierarchy.h"
 #include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 namespace route_opt {
 RouteGenerator::RouteGenerator(unsigned seed) : rng_(seed) {}
@@ -34,6 +36,17 @@ std::vector<std::vector<double>> RouteGenerator::generateEuclidean(const PointVe
  return distances;
 }
 
+void RouteGenerator::generateEuclidean(const PointVector& points, double* distances) const {
+  const size_t numPoints = points.size();
+
+  #pragma omp parallel for
+  for (size_t i = 0; i < numPoints; ++i) {
+    for (size_t j = 0; j < numPoints; ++j) {
+      distances[i * numPoints + j] = calculateDistance(points[i], points[j]);
+    }
+  }
+}
+
 std::pair<PointVector, std::vector<std::vector<double>>> RouteGenerator::generateRandomEuclidean( const GeneratorConfig &config) {
   PointVector points;
   points.reserve(config.numPoints);
@@ -73,6 +86,104 @@ std::vector<std::vector<double>> RouteGenerator::generateRoadNetwork(const Point
   return distances;
 }
 
+std::vector<std::vector<double>> RouteGenerator::generateRoadNetwork(
+    const RoadGraph& graph,
+    const PointVector& stops) const {
+
+    const auto nodes = graph.nearestNodes(stops);
+    auto distances = ContractionHierarchy(graph).manyToMany(nodes, nodes);
+
+    // An infinite entry would pass as a distance to every optimizer, so
+    // name the stops in unreachable pairs instead.
+    const size_t n = stops.size();
+    std::vector<char> cut(n, 0);
+    std::string example;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (!std::isinf(distances[i][j])) continue;
+            cut[i] = cut[j] = 1;
+            if (example.empty()) example = std::to_string(i) + " -> " + std::to_string(j);
+        }
+    }
+    std::string unreachable;
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!cut[i]) continue;
+        if (++count <= 10) unreachable += (count > 1 ? ", " : "") + std::to_string(i);
+    }
+    if (count > 0) {
+        if (count > 10) unreachable += " and " + std::to_string(count - 10) + " more";
+        throw std::runtime_error("Road graph does not connect every pair of stops (e.g. " +
+                                 example + "); stops involved: " + unreachable);
+    }
+    return distances;
+}
+
+QuantizedMatrix RouteGenerator::generateRoadNetwork(
+    const RoadGraph& graph,
+    const PointVector& stops,
+    DistancePrecision precision,
+    double quantum) const {
+
+    const auto nodes = graph.nearestNodes(stops);
+    return ContractionHierarchy(graph).manyToMany(nodes, precision, quantum);
+}
+
+RoadGraph RouteGenerator::generateRoadGraph(const GeneratorConfig& config) {
+    const size_t side = std::max<size_t>(
+        2, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(config.numPoints)))));
+    const double spacing = (config.maxCoord - config.minCoord) / (side - 1);
+    const size_t kArterialSpacing = 8;
+    const double kArterialSpeed = 2.0;
+
+    std::uniform_real_distribution<double> jitter(-0.3 * spacing, 0.3 * spacing);
+    std::uniform_real_distribution<double> trafficDist(1.0, 1.0 + config.trafficFactor);
+    std::uniform_real_distribution<double> oneWayDist(0.0, 1.0);
+
+    PointVector nodes(side * side);
+    for (size_t r = 0; r < side; ++r) {
+        for (size_t c = 0; c < side; ++c) {
+            nodes[r * side + c] = Point{config.minCoord + c * spacing + jitter(rng_),
+                                        config.minCoord + r * spacing + jitter(rng_)};
+        }
+    }
+
+    // Streets 0..side-1 run along rows, side..2*side-1 along columns.
+    // Direction 0 is two-way, +1 / -1 one-way towards higher / lower indices.
+    std::vector<int> direction(2 * side, 0);
+    std::vector<double> speed(2 * side, 1.0);
+    for (size_t street = 0; street < 2 * side; ++street) {
+        const size_t line = street % side;
+        if (line == 0 || line == side - 1 || line % kArterialSpacing == 0) {
+            if (line % kArterialSpacing == 0 && line != 0) speed[street] = kArterialSpeed;
+            continue;
+        }
+        if (oneWayDist(rng_) < config.oneWayProbability) {
+            direction[street] = line % 2 == 0 ? 1 : -1;
+        }
+    }
+
+    std::vector<RoadGraph::Arc> arcs;
+    auto connect = [&](size_t a, size_t b, size_t street) {
+        const double length = calculateDistance(nodes[a], nodes[b]);
+        if (direction[street] >= 0) {
+            arcs.push_back({static_cast<int>(a), static_cast<int>(b),
+                            length / speed[street] * trafficDist(rng_)});
+        }
+        if (direction[street] <= 0) {
+            arcs.push_back({static_cast<int>(b), static_cast<int>(a),
+                            length / speed[street] * trafficDist(rng_)});
+        }
+    };
+    for (size_t r = 0; r < side; ++r) {
+        for (size_t c = 0; c + 1 < side; ++c) {
+            connect(r * side + c, r * side + c + 1, r);
+            connect(c * side + r, (c + 1) * side + r, side + r);
+        }
+    }
+
+    return RoadGraph(std::move(nodes), arcs);
+}
 
 std::vector<std::vector<std::vector<double>>>
 RouteGenerator::generateTimeDependent(
@@ -126,6 +237,24 @@ double RouteGenerator::calculateTimeFactor(
     return 1.0;
 }
 
+std::vector<double> RouteGenerator::generateDemands(
+    size_t numPoints,
+    size_t depot,
+    const GeneratorConfig& config) {
+
+    std::uniform_int_distribution<long> demandDist(
+        static_cast<long>(std::ceil(config.minDemand)),
+        static_cast<long>(std::floor(config.maxDemand)));
+
+    std::vector<double> demands(numPoints, 0.0);
+    for (size_t i = 0; i < numPoints; ++i) {
+        if (i != depot) {
+            demands[i] = static_cast<double>(demandDist(rng_));
+        }
+    }
+    return demands;
+}
+
 void RouteGenerator::saveToFile(
     const std::vector<std::vector<double>>& distances,
     const std::string& filename) const {
@@ -269,10 +398,10 @@ bool isValidDistanceMatrix(
         if (distances[i][i] != 0.0) return false;
     }
 
-    // Check non-negative distances
+    // Check finite, non-negative distances
     for (const auto& row : distances) {
         if (std::any_of(row.begin(), row.end(),
-            [](double d) { return d < 0.0; })) {
+            [](double d) { return !std::isfinite(d) || d < 0.0; })) {
             return false;
         }
     }
@@ -0,0 +1,26 @@
+#include "route_manager.h"
+#include <stdexcept>
+
+namespace route_opt {
+
+RouteManager::RouteManager(bool useGPU)
+    : optimizer_(RouteOptimizer::createOptimizer(useGPU)) {
+  if (!optimizer_) {
+    throw std::runtime_error("Failed to create optimizer");
+  }
+  optimizer_->setWorkspace(&workspace_);
+}
+
+void RouteManager::setPoints(const PointVector& points) {
+  // assign() reuses the existing capacity across instances.
+  points_.assign(points.begin(), points.end());
+}
+
+Route RouteManager::optimize() {
+  if (points_.empty()) {
+    throw std::runtime_error("No points to optimize");
+  }
+  return optimizer_->findOptimalRoute(points_);
+}
+
+}; // namespace route_opt
@@ -0,0 +1,237 @@
+#include "spatial_index.h"
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace route_opt {
+
+SpatialGrid::SpatialGrid(const PointVector& points, size_t pointsPerCell,
+                         std::pmr::memory_resource* memory)
+    : points_(points), memory_(memory), cellStart_(memory), cellPoints_(memory) {
+  const size_t n = points.size();
+  if (n == 0) {
+    cellStart_.assign(2, 0);
+    return;
+  }
+
+  double maxX = points[0].x, maxY = points[0].y;
+  minX_ = points[0].x;
+  minY_ = points[0].y;
+  for (const auto& p : points) {
+    minX_ = std::min(minX_, p.x);
+    minY_ = std::min(minY_, p.y);
+    maxX = std::max(maxX, p.x);
+    maxY = std::max(maxY, p.y);
+  }
+
+  // Square cells sized so that each holds roughly pointsPerCell points.
+  const double width = std::max(maxX - minX_, 1e-9);
+  const double height = std::max(maxY - minY_, 1e-9);
+  const double cells = std::max<double>(1.0, double(n) / std::max<size_t>(pointsPerCell, 1));
+  cellSize_ = std::sqrt(width * height / cells);
+  if (cellSize_ <= 0.0 || !std::isfinite(cellSize_)) {
+    cellSize_ = std::max(width, height);
+  }
+  cols_ = std::max<long>(1, long(width / cellSize_) + 1);
+  rows_ = std::max<long>(1, long(height / cellSize_) + 1);
+
+  std::pmr::vector<long> cellOfPoint(n, memory_);
+  cellStart_.assign(cols_ * rows_ + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    cellOfPoint[i] = cellY(points[i].y) * cols_ + cellX(points[i].x);
+    ++cellStart_[cellOfPoint[i] + 1];
+  }
+  for (size_t c = 1; c < cellStart_.size(); ++c) {
+    cellStart_[c] += cellStart_[c - 1];
+  }
+
+  cellPoints_.resize(n);
+  std::pmr::vector<int> fill(cellStart_.begin(), cellStart_.end() - 1, memory_);
+  for (size_t i = 0; i < n; ++i) {
+    cellPoints_[fill[cellOfPoint[i]]++] = static_cast<int>(i);
+  }
+}
+
+long SpatialGrid::cellX(double x) const {
+  return std::clamp<long>(long((x - minX_) / cellSize_), 0, cols_ - 1);
+}
+
+long SpatialGrid::cellY(double y) const {
+  return std::clamp<long>(long((y - minY_) / cellSize_), 0, rows_ - 1);
+}
+
+std::vector<int> SpatialGrid::nearestNeighbors(size_t k) const {
+  std::vector<int> neighbors(points_.size() * k);
+  nearestNeighbors(k, neighbors.data());
+  return neighbors;
+}
+
+void SpatialGrid::nearestNeighbors(size_t k, int* neighbors) const {
+  const long n = static_cast<long>(points_.size());
+  std::fill(neighbors, neighbors + n * k, -1);
+  if (k == 0) {
+    return;
+  }
+
+  // One max-heap of (squared distance, index) per thread, holding the best
+  // k candidates seen so far for the current point.
+  using Candidate = std::pair<double, int>;
+  std::pmr::vector<Candidate> heaps(k * omp_get_max_threads(), memory_);
+
+#pragma omp parallel for schedule(dynamic, 256)
+  for (long i = 0; i < n; ++i) {
+    const Point& p = points_[i];
+    const long cx = cellX(p.x);
+    const long cy = cellY(p.y);
+
+    Candidate* best = &heaps[k * omp_get_thread_num()];
+    size_t size = 0;
+
+    // Scan square rings of cells around the query cell. Every cell in ring
+    // r + 1 is at least r * cellSize_ away, which bounds the search.
+    for (long r = 0;; ++r) {
+      const bool full = size == k;
+      const double reach = (r - 1) * cellSize_;
+      if (full && r > 0 && best[0].first <= reach * reach) {
+        break;
+      }
+      if (cx - r < 0 && cy - r < 0 && cx + r >= cols_ && cy + r >= rows_) {
+        break;
+      }
+
+      for (long y = cy - r; y <= cy + r; ++y) {
+        if (y < 0 || y >= rows_) continue;
+        const bool edgeRow = (y == cy - r || y == cy + r);
+        for (long x = cx - r; x <= cx + r; x += (edgeRow ? 1 : 2 * r)) {
+          if (x >= 0 && x < cols_) {
+            const long cell = y * cols_ + x;
+            for (int c = cellStart_[cell]; c < cellStart_[cell + 1]; ++c) {
+              const int j = cellPoints_[c];
+              if (j == i) continue;
+              const double dx = points_[j].x - p.x;
+              const double dy = points_[j].y - p.y;
+              const double d2 = dx * dx + dy * dy;
+              if (size < k) {
+                best[size++] = {d2, j};
+                std::push_heap(best, best + size);
+              } else if (d2 < best[0].first) {
+                std::pop_heap(best, best + size);
+                best[size - 1] = {d2, j};
+                std::push_heap(best, best + size);
+              }
+            }
+          }
+          if (r == 0) break;
+        }
+      }
+    }
+
+    std::sort_heap(best, best + size);
+    for (size_t slot = 0; slot < size; ++slot) {
+      neighbors[i * k + slot] = best[slot].second;
+    }
+  }
+}
+
+int SpatialGrid::nearest(const Point& query) const {
+  return nearestOutside(query, nullptr, -1, std::numeric_limits<double>::infinity());
+}
+
+int SpatialGrid::nearestOutside(const Point& query, const int* labels, int exclude,
+                                double maxDistance) const {
+  const long cx = cellX(query.x);
+  const long cy = cellY(query.y);
+  int best = -1;
+  double bestDistance = maxDistance * maxDistance;
+
+  // Same ring scan as nearestNeighbors(). Clamping a query outside the box
+  // to the border cell keeps the ring bound valid.
+  for (long r = 0;; ++r) {
+    const double reach = (r - 1) * cellSize_;
+    if (r > 0 && bestDistance <= reach * reach) {
+      break;
+    }
+    if (cx - r < 0 && cy - r < 0 && cx + r >= cols_ && cy + r >= rows_) {
+      break;
+    }
+
+    for (long y = cy - r; y <= cy + r; ++y) {
+      if (y < 0 || y >= rows_) continue;
+      const bool edgeRow = (y == cy - r || y == cy + r);
+      for (long x = cx - r; x <= cx + r; x += (edgeRow ? 1 : 2 * r)) {
+        if (x >= 0 && x < cols_) {
+          const long cell = y * cols_ + x;
+          for (int c = cellStart_[cell]; c < cellStart_[cell + 1]; ++c) {
+            const int j = cellPoints_[c];
+            if (labels && (labels[j] == exclude || labels[j] < 0)) continue;
+            const double dx = points_[j].x - query.x;
+            const double dy = points_[j].y - query.y;
+            const double d2 = dx * dx + dy * dy;
+            if (d2 < bestDistance) {
+              best = j;
+              bestDistance = d2;
+            }
+          }
+        }
+        if (r == 0) break;
+      }
+    }
+  }
+  return best;
+}
+
+std::vector<int> hilbertOrder(const PointVector& points) {
+  std::vector<int> order(points.size());
+  hilbertOrder(points, order.data(), std::pmr::get_default_resource());
+  return order;
+}
+
+void hilbertOrder(const PointVector& points, int* order,
+                  std::pmr::memory_resource* memory) {
+  const size_t n = points.size();
+  std::iota(order, order + n, 0);
+  if (n < 3) {
+    return;
+  }
+
+  double minX = points[0].x, maxX = points[0].x;
+  double minY = points[0].y, maxY = points[0].y;
+  for (const auto& p : points) {
+    minX = std::min(minX, p.x);
+    maxX = std::max(maxX, p.x);
+    minY = std::min(minY, p.y);
+    maxY = std::max(maxY, p.y);
+  }
+  const double extent = std::max({maxX - minX, maxY - minY, 1e-12});
+
+  constexpr uint32_t side = 1u << 16;
+  std::pmr::vector<uint64_t> keys(n, memory);
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t x = std::min<uint32_t>(side - 1, uint32_t((points[i].x - minX) / extent * side));
+    uint32_t y = std::min<uint32_t>(side - 1, uint32_t((points[i].y - minY) / extent * side));
+
+    uint64_t d = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+      const uint32_t rx = (x & s) ? 1 : 0;
+      const uint32_t ry = (y & s) ? 1 : 0;
+      d += uint64_t(s) * s * ((3 * rx) ^ ry);
+      if (ry == 0) {
+        if (rx == 1) {
+          x = side - 1 - x;
+          y = side - 1 - y;
+        }
+        std::swap(x, y);
+      }
+    }
+    keys[i] = d;
+  }
+
+  std::sort(order, order + n,
+            [&keys](int a, int b) { return keys[a] < keys[b]; });
+}
+
+}; // namespace route_opt
@@ -0,0 +1,579 @@
+#include "time_windows.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+constexpr double kEpsilon = 1e-9;
+// Up to this many stops every order is tried: at most 8! schedules.
+constexpr size_t kExhaustiveStops = 8;
+
+double travelTime(const TimeWindowProblem& problem, int from, int to, double t) {
+  const double slot = std::floor(std::max(t, 0.0) / problem.slotLength);
+  const size_t index = static_cast<size_t>(
+      std::fmod(slot, static_cast<double>(problem.travelTimes.size())));
+  return problem.travelTimes[index][from][to];
+}
+
+bool better(double warpA, double travelA, double warpB, double travelB) {
+  if (warpA < warpB - kEpsilon) return true;
+  if (warpA > warpB + kEpsilon) return false;
+  return travelA < travelB - kEpsilon;
+}
+
+// Summary of a partial route (Vidal et al.): minimum duration, unavoidable
+// time warp, earliest and latest start that achieve them, and travel time.
+// Two summaries combine in O(1) for given travel times between them. The
+// slacks say how far the departures inside the segment can move later or
+// earlier before one crosses into another time slot; within them its
+// travel times, and so the summary, stay exact.
+struct Segment {
+  int first, last;
+  double duration, timeWarp, earliest, latest, travel;
+  double lateSlack, earlySlack;
+};
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// A summary that starts at the depot at a fixed time is a schedule prefix;
+// this is when it leaves its last node.
+double departure(const Segment& prefix) {
+  return prefix.earliest + prefix.duration - prefix.timeWarp;
+}
+
+// Local search over one route. Moves are drawn from candidate lists through
+// a work queue of nodes with don't-look bits. A candidate route is an
+// unchanged prefix followed by pieces of the current route, each entered at
+// the time the new prefix reaches it. Screening takes every run from a
+// sparse table of summaries in O(log n), with a second table for runs
+// walked backwards. Confirmation only uses a forward run while the shift
+// stays within its slot slack and walks the rest, which makes it exact.
+// With a single time slot the two agree.
+class ScheduleSearch {
+public:
+  ScheduleSearch(const TimeWindowProblem& problem, const TimeWindowOptimizer& optimizer,
+                 const TimeWindowConfig& config);
+
+  ScheduledRoute run(std::vector<int> path);
+
+private:
+  // Positions [from, to] of the current route, walked backwards if from > to.
+  struct Piece {
+    int from, to;
+  };
+  // Reverse positions [i, j], or move them to just after position `after`.
+  struct Move {
+    Segment result;
+    int i, j, after;
+  };
+  // Travel time of one arc of the current route at its current departure,
+  // with that departure's slot slack.
+  struct Arc {
+    double travel, lateSlack, earlySlack;
+  };
+
+  const TimeWindowProblem& problem_;
+  const TimeWindowOptimizer& optimizer_;
+  const TimeWindowConfig& config_;
+  size_t k_ = 0;
+  std::vector<int> neighbors_;
+
+  // Depot, stops, depot again; positions index into this array.
+  std::vector<int> nodes_;
+  std::vector<int> pos_;
+  // Exact schedule of the current route: service start per position and
+  // departure per node.
+  std::vector<double> start_;
+  std::vector<double> depart_;
+  // ahead_[p] is the arc from position p to p + 1, behind_[p] the arc from
+  // p + 1 back to p.
+  std::vector<Arc> ahead_;
+  std::vector<Arc> behind_;
+  // forward_[p] summarises positions [0, p]; table_[level][p] summarises
+  // [p, p + 2^level) and reversed_[level][p] the same positions walked
+  // backwards, with travel times taken at the current departures.
+  std::vector<Segment> forward_;
+  std::vector<std::vector<Segment>> table_;
+  std::vector<std::vector<Segment>> reversed_;
+  ScheduledRoute current_;
+
+  std::vector<int> queue_;
+  std::vector<char> queued_;
+  std::vector<Move> improving_;
+  size_t head_ = 0;
+
+  int last() const { return static_cast<int>(nodes_.size()) - 1; }
+
+  double lateSlack(double departure) const;
+  double earlySlack(double departure) const;
+  Segment single(int position) const;
+  Segment join(const Segment& a, const Segment& b, double travel) const;
+  Arc arc(int from, int to) const;
+  Segment link(const Segment& a, const Segment& b, const Arc& arc) const;
+  Segment range(int from, int to) const;
+  Segment reversedRange(int from, int to) const;
+  Segment extend(Segment prefix, std::initializer_list<Piece> pieces, bool exact) const;
+  void rebuild(int from);
+  void push(int v);
+
+  Segment score(const Move& move, bool exact) const;
+  void consider(const Move& move, std::vector<Move>& improving) const;
+  void twoOptMoves(int u, std::vector<Move>& improving) const;
+  void orOptMoves(int u, std::vector<Move>& improving) const;
+  bool improve(int u);
+};
+
+ScheduleSearch::ScheduleSearch(const TimeWindowProblem& problem,
+                               const TimeWindowOptimizer& optimizer,
+                               const TimeWindowConfig& config)
+    : problem_(problem), optimizer_(optimizer), config_(config) {
+  const int n = static_cast<int>(problem.windows.size());
+  k_ = std::min<size_t>(config.candidateNeighbors, n - 1);
+
+  // Mean travel time over the slots, then the time-window correlation of
+  // Vidal et al.: travel plus weighted waiting and lateness of going u -> v.
+  std::vector<double> mean(size_t(n) * n, 0.0);
+  for (const auto& slot : problem.travelTimes) {
+    for (int u = 0; u < n; ++u) {
+      for (int v = 0; v < n; ++v) mean[size_t(u) * n + v] += slot[u][v];
+    }
+  }
+  for (double& t : mean) t /= problem.travelTimes.size();
+  auto proximity = [&](int u, int v) {
+    const TimeWindow& a = problem.windows[u];
+    const TimeWindow& b = problem.windows[v];
+    const double t = mean[size_t(u) * n + v];
+    return t + 0.2 * std::max(b.earliest - t - a.serviceTime - a.latest, 0.0) +
+           std::max(a.earliest + a.serviceTime + t - b.latest, 0.0);
+  };
+
+  neighbors_.assign(size_t(n) * k_, -1);
+  std::vector<std::pair<double, int>> row;
+  for (int u = 0; u < n; ++u) {
+    row.clear();
+    for (int v = 0; v < n; ++v) {
+      if (v != u) row.push_back({std::min(proximity(u, v), proximity(v, u)), v});
+    }
+    std::partial_sort(row.begin(), row.begin() + k_, row.end());
+    for (size_t i = 0; i < k_; ++i) neighbors_[u * k_ + i] = row[i].second;
+  }
+}
+
+double ScheduleSearch::lateSlack(double departure) const {
+  if (problem_.travelTimes.size() == 1) return kInfinity;
+  const double slot = std::floor(std::max(departure, 0.0) / problem_.slotLength);
+  return (slot + 1.0) * problem_.slotLength - departure;
+}
+
+double ScheduleSearch::earlySlack(double departure) const {
+  if (problem_.travelTimes.size() == 1 || departure <= 0.0) return kInfinity;
+  return departure - std::floor(departure / problem_.slotLength) * problem_.slotLength;
+}
+
+Segment ScheduleSearch::single(int position) const {
+  const int v = nodes_[position];
+  if (position == 0) {
+    const double t = problem_.departureTime;
+    return {v, v, 0.0, 0.0, t, t, 0.0, kInfinity, kInfinity};
+  }
+  const TimeWindow& w = problem_.windows[v];
+  const double service = position == last() ? 0.0 : w.serviceTime;
+  return {v, v, service, 0.0, w.earliest, w.latest, 0.0, kInfinity, kInfinity};
+}
+
+Segment ScheduleSearch::join(const Segment& a, const Segment& b, double travel) const {
+  const double delta = a.duration - a.timeWarp + travel;
+  const double wait = std::max(b.earliest - delta - a.latest, 0.0);
+  const double warp = std::max(a.earliest + delta - b.latest, 0.0);
+  return {a.first,
+          b.last,
+          a.duration + b.duration + travel + wait,
+          a.timeWarp + b.timeWarp + warp,
+          std::max(b.earliest - delta, a.earliest) - wait,
+          std::min(b.latest - delta, a.latest) + warp,
+          a.travel + b.travel + travel,
+          std::min(a.lateSlack, b.lateSlack),
+          std::min(a.earlySlack, b.earlySlack)};
+}
+
+ScheduleSearch::Arc ScheduleSearch::arc(int from, int to) const {
+  const double leave = depart_[nodes_[from]];
+  return {travelTime(problem_, nodes_[from], nodes_[to], leave), lateSlack(leave),
+          earlySlack(leave)};
+}
+
+// Joins two runs of the current route over one of its arcs.
+Segment ScheduleSearch::link(const Segment& a, const Segment& b, const Arc& arc) const {
+  Segment joined = join(a, b, arc.travel);
+  joined.lateSlack = std::min(joined.lateSlack, arc.lateSlack);
+  joined.earlySlack = std::min(joined.earlySlack, arc.earlySlack);
+  return joined;
+}
+
+// Positions [from, to] walked from `to` down to `from`.
+Segment ScheduleSearch::reversedRange(int from, int to) const {
+  int level = 0;
+  while ((2 << level) <= to - from + 1) ++level;
+  int p = to + 1 - (1 << level);
+  Segment result = reversed_[level][p];
+  while (p > from) {
+    while (p - (1 << level) < from) --level;
+    p -= 1 << level;
+    result = link(result, reversed_[level][p], behind_[p + (1 << level) - 1]);
+  }
+  return result;
+}
+
+Segment ScheduleSearch::range(int from, int to) const {
+  int level = 0;
+  while ((2 << level) <= to - from + 1) ++level;
+  Segment result = table_[level][from];
+  for (int p = from + (1 << level); p <= to;) {
+    while (p + (1 << level) - 1 > to) --level;
+    result = link(result, table_[level][p], ahead_[p - 1]);
+    p += 1 << level;
+  }
+  return result;
+}
+
+// Schedules `pieces` after `prefix`, entering each at the time the new
+// route reaches it. Runs come from their summaries, which assume their
+// current travel times. With `exact` a forward run is only taken while the
+// shift of its start stays within its slot slack, and a reversed one only
+// when there is a single slot; otherwise the run is walked, and a forward
+// suffix is re-checked after every node so a shift that waiting absorbs
+// ends the walk early.
+Segment ScheduleSearch::extend(Segment prefix, std::initializer_list<Piece> pieces,
+                               bool exact) const {
+  const int m = last();
+  for (const Piece& piece : pieces) {
+    const int step = piece.from <= piece.to ? 1 : -1;
+    for (int q = piece.from;; q += step) {
+      const int v = nodes_[q];
+      const double leave = departure(prefix);
+      const double travel = travelTime(problem_, prefix.last, v, leave);
+
+      if (step < 0 && q == piece.from && (!exact || problem_.travelTimes.size() == 1)) {
+        prefix = join(prefix, reversedRange(piece.to, piece.from), travel);
+        break;
+      }
+      if (step > 0 && q < piece.to && (q == piece.from || piece.to == m)) {
+        const TimeWindow& w = problem_.windows[v];
+        const double shift = std::min(std::max(leave + travel, w.earliest), w.latest) - start_[q];
+        const Segment run = range(q, piece.to);
+        if (!exact || (shift < run.lateSlack && -shift <= run.earlySlack)) {
+          prefix = join(prefix, run, travel);
+          break;
+        }
+      }
+
+      prefix = join(prefix, single(q), travel);
+      if (q == piece.to) break;
+    }
+  }
+  return prefix;
+}
+
+// Refreshes everything that depends on positions `from` onwards; earlier
+// positions keep their nodes and times, and so their summaries.
+void ScheduleSearch::rebuild(int from) {
+  current_ = optimizer_.evaluate(problem_, std::vector<int>(nodes_.begin(), nodes_.end() - 1));
+
+  const int m = last();
+  for (int p = from; p < m; ++p) {
+    const int v = nodes_[p];
+    start_[p] = current_.startTimes[p];
+    depart_[v] = start_[p] + (p == 0 ? 0.0 : problem_.windows[v].serviceTime);
+    pos_[v] = p;
+  }
+  start_[m] = current_.returnTime;
+  depart_[nodes_[0]] = problem_.departureTime;
+
+  for (int p = std::max(from - 1, 0); p < m; ++p) {
+    ahead_[p] = arc(p, p + 1);
+    behind_[p] = arc(p + 1, p);
+  }
+
+  for (int p = from; p <= m; ++p) table_[0][p] = reversed_[0][p] = single(p);
+  for (size_t level = 1; level < table_.size(); ++level) {
+    const int half = 1 << (level - 1);
+    const int size = static_cast<int>(table_[level].size());
+    for (int p = std::max(from - 2 * half + 1, 0); p < size; ++p) {
+      const int middle = p + half - 1;
+      table_[level][p] =
+          link(table_[level - 1][p], table_[level - 1][p + half], ahead_[middle]);
+      reversed_[level][p] =
+          link(reversed_[level - 1][p + half], reversed_[level - 1][p], behind_[middle]);
+    }
+  }
+
+  for (int p = std::max(from, 1); p <= m; ++p) {
+    forward_[p] = link(forward_[p - 1], single(p), ahead_[p - 1]);
+  }
+}
+
+void ScheduleSearch::push(int v) {
+  if (v == problem_.depot || queued_[v]) return;
+  queued_[v] = 1;
+  queue_.push_back(v);
+}
+
+Segment ScheduleSearch::score(const Move& move, bool exact) const {
+  const int m = last();
+  const int i = move.i;
+  const int j = move.j;
+  const int after = move.after;
+  if (after < 0) return extend(forward_[i - 1], {{j, i}, {j + 1, m}}, exact);
+  if (after < i) return extend(forward_[after], {{i, j}, {after + 1, i - 1}, {j + 1, m}}, exact);
+  return extend(forward_[i - 1], {{j + 1, after}, {i, j}, {after + 1, m}}, exact);
+}
+
+// Keeps a move whose screening score beats the current route.
+void ScheduleSearch::consider(const Move& move, std::vector<Move>& improving) const {
+  const Segment& now = forward_[last()];
+  const Segment result = score(move, false);
+  if (better(result.timeWarp, result.travel, now.timeWarp, now.travel)) {
+    improving.push_back({result, move.i, move.j, move.after});
+  }
+}
+
+// Reversals that make u and a candidate neighbour v consecutive.
+void ScheduleSearch::twoOptMoves(int u, std::vector<Move>& improving) const {
+  const int p = pos_[u];
+  for (size_t c = 0; c < k_; ++c) {
+    const int v = neighbors_[u * k_ + c];
+    if (v == problem_.depot) continue;
+    const int q = pos_[v];
+
+    // u -> v: reverse [p + 1, q]. v -> u: reverse [q + 1, p].
+    const int i = q > p ? p + 1 : q + 1;
+    const int j = q > p ? q : p;
+    if (j - i >= 1) consider({{}, i, j, -1}, improving);
+  }
+}
+
+// Moves of a segment that starts or ends at u to either side of a
+// candidate neighbour.
+void ScheduleSearch::orOptMoves(int u, std::vector<Move>& improving) const {
+  const int m = last();
+  const int p = pos_[u];
+  for (int length = 1; length <= int(config_.maxSegmentLength); ++length) {
+    for (int i : {p, p - length + 1}) {
+      const int e = i + length - 1;
+      if (i < 1 || e > m - 1 || (length == 1 && i != p)) continue;
+
+      for (size_t c = 0; c < k_; ++c) {
+        const int v = neighbors_[u * k_ + c];
+        const int q = v == problem_.depot ? -1 : pos_[v];
+        // Positions the segment can go after: next to v on either side.
+        for (int after : {q < 0 ? 0 : q, q < 0 ? m - 1 : q - 1}) {
+          if (after < i - 1 || after > e) consider({{}, i, e, after}, improving);
+        }
+      }
+    }
+  }
+}
+
+// Applies the best move around u that beats the current route. Screening
+// scores assume the travel times inside unchanged runs stay as they are,
+// so the candidates are confirmed exactly, best first.
+bool ScheduleSearch::improve(int u) {
+  improving_.clear();
+  twoOptMoves(u, improving_);
+  orOptMoves(u, improving_);
+  std::sort(improving_.begin(), improving_.end(), [](const Move& a, const Move& b) {
+    return better(a.result.timeWarp, a.result.travel, b.result.timeWarp, b.result.travel);
+  });
+
+  const Segment& now = forward_[last()];
+  for (const Move& move : improving_) {
+    const Segment result = score(move, true);
+    if (!better(result.timeWarp, result.travel, now.timeWarp, now.travel)) continue;
+
+    const int i = move.i;
+    const int j = move.j;
+    const int after = move.after;
+    auto build = [&] {
+      std::vector<int> path = nodes_;
+      if (after < 0) {
+        std::reverse(path.begin() + i, path.begin() + j + 1);
+      } else {
+        std::vector<int> piece(path.begin() + i, path.begin() + j + 1);
+        path.erase(path.begin() + i, path.begin() + j + 1);
+        const int at = after < i ? after + 1 : after - j + i;
+        path.insert(path.begin() + at, piece.begin(), piece.end());
+      }
+      return path;
+    };
+
+    std::vector<int> path = build();
+    for (int position : {i - 1, i, j, j + 1}) push(nodes_[position]);
+    if (after >= 0) {
+      push(nodes_[after]);
+      push(nodes_[after + 1]);
+    }
+    nodes_ = std::move(path);
+    rebuild(after >= 0 && after < i ? after + 1 : i);
+    return true;
+  }
+  return false;
+}
+
+ScheduledRoute ScheduleSearch::run(std::vector<int> path) {
+  nodes_ = std::move(path);
+  nodes_.push_back(problem_.depot);
+  pos_.assign(problem_.windows.size(), 0);
+  depart_.assign(problem_.windows.size(), problem_.departureTime);
+  const int m = last();
+  start_.resize(m + 1);
+  ahead_.resize(m);
+  behind_.resize(m);
+  forward_.resize(m + 1);
+  forward_[0] = single(0);
+  table_.assign(1, std::vector<Segment>(m + 1));
+  for (int level = 1; (1 << level) <= m + 1; ++level) {
+    table_.emplace_back(m + 2 - (1 << level));
+  }
+  reversed_ = table_;
+  rebuild(0);
+
+  queued_.assign(problem_.windows.size(), 0);
+  size_t moves = 0;
+  // A move shifts the schedule of every later stop, which can open moves
+  // around nodes whose bits are set, so the queue is refilled until a whole
+  // pass finds nothing.
+  for (size_t passStart = 0;; passStart = moves) {
+    queue_.clear();
+    head_ = 0;
+    for (int p = 1; p < last(); ++p) push(nodes_[p]);
+
+    while (head_ < queue_.size() && moves < config_.maxMoves) {
+      const int u = queue_[head_++];
+      queued_[u] = 0;
+      if (improve(u)) {
+        push(u);
+        ++moves;
+      }
+      // Reclaim the consumed front once it dominates the buffer.
+      if (head_ > 1024 && head_ * 2 > queue_.size()) {
+        queue_.erase(queue_.begin(), queue_.begin() + head_);
+        head_ = 0;
+      }
+    }
+    if (moves == passStart || moves >= config_.maxMoves) break;
+    for (size_t q = head_; q < queue_.size(); ++q) queued_[queue_[q]] = 0;
+  }
+  return current_;
+}
+} // namespace
+
+TimeWindowOptimizer::TimeWindowOptimizer(const TimeWindowConfig& config)
+    : config_(config) {}
+
+ScheduledRoute TimeWindowOptimizer::evaluate(const TimeWindowProblem& problem,
+                                             const std::vector<int>& path) const {
+  ScheduledRoute schedule;
+  schedule.route.path = path;
+  schedule.route.totalDistance = 0.0;
+  schedule.startTimes.resize(path.size());
+  if (path.empty()) {
+    return schedule;
+  }
+
+  double t = problem.departureTime;
+  schedule.startTimes[0] = t;
+
+  auto visit = [&](int from, int to) {
+    const double travel = travelTime(problem, from, to, t);
+    schedule.route.totalDistance += travel;
+    t += travel;
+    const TimeWindow& w = problem.windows[to];
+    t = std::max(t, w.earliest);
+    if (t > w.latest) {
+      schedule.timeWarp += t - w.latest;
+      t = w.latest;
+    }
+  };
+
+  for (size_t i = 1; i < path.size(); ++i) {
+    visit(path[i - 1], path[i]);
+    schedule.startTimes[i] = t;
+    t += problem.windows[path[i]].serviceTime;
+  }
+  visit(path.back(), path.front());
+  schedule.returnTime = t;
+
+  return schedule;
+}
+
+ScheduledRoute TimeWindowOptimizer::solve(const TimeWindowProblem& problem) const {
+  const size_t n = problem.windows.size();
+  if (problem.travelTimes.empty() || problem.slotLength <= 0.0) {
+    throw std::invalid_argument("Time-dependent travel times are required");
+  }
+  for (const auto& slot : problem.travelTimes) {
+    if (slot.size() != n || std::any_of(slot.begin(), slot.end(),
+                                        [n](const auto& row) { return row.size() != n; })) {
+      throw std::invalid_argument("Travel time slots must be n x n with one window per stop");
+    }
+  }
+  if (problem.depot < 0 || size_t(problem.depot) >= n) {
+    throw std::invalid_argument("Depot index out of range");
+  }
+
+  // Start from the stops ordered by deadline, which is feasible whenever
+  // the windows are loose enough for any order to be.
+  std::vector<int> path;
+  for (size_t v = 0; v < n; ++v) {
+    if (int(v) != problem.depot) path.push_back(v);
+  }
+  std::stable_sort(path.begin(), path.end(), [&problem](int a, int b) {
+    const TimeWindow& wa = problem.windows[a];
+    const TimeWindow& wb = problem.windows[b];
+    return wa.latest < wb.latest || (wa.latest == wb.latest && wa.earliest < wb.earliest);
+  });
+  path.insert(path.begin(), problem.depot);
+
+  if (path.size() < 3) {
+    return evaluate(problem, path);
+  }
+  if (path.size() - 1 <= kExhaustiveStops) {
+    std::sort(path.begin() + 1, path.end());
+    ScheduledRoute best = evaluate(problem, path);
+    while (std::next_permutation(path.begin() + 1, path.end())) {
+      ScheduledRoute candidate = evaluate(problem, path);
+      if (better(candidate.timeWarp, candidate.route.totalDistance, best.timeWarp,
+                 best.route.totalDistance)) {
+        best = std::move(candidate);
+      }
+    }
+    return best;
+  }
+  if (problem.travelTimes.size() == 1) {
+    return ScheduleSearch(problem, *this, config_).run(std::move(path));
+  }
+
+  // Moves screened on shifting slot times often fail confirmation, and a
+  // search started from the deadline order stalls in poor tours. Optimise
+  // on the mean travel times first, where screening is exact, and refine
+  // that tour on the real ones.
+  TimeWindowProblem mean = problem;
+  mean.travelTimes.assign(1, std::vector<std::vector<double>>(n, std::vector<double>(n, 0.0)));
+  for (const auto& slot : problem.travelTimes) {
+    for (size_t u = 0; u < n; ++u) {
+      for (size_t v = 0; v < n; ++v) mean.travelTimes[0][u][v] += slot[u][v];
+    }
+  }
+  for (auto& row : mean.travelTimes[0]) {
+    for (double& t : row) t /= problem.travelTimes.size();
+  }
+  path = ScheduleSearch(mean, *this, config_).run(std::move(path)).route.path;
+  return ScheduleSearch(problem, *this, config_).run(std::move(path));
+}
+
+}; // namespace route_opt
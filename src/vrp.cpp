@@ -0,0 +1,413 @@
+#include "vrp.h"
+#include "spatial_index.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace route_opt {
+
+namespace {
+constexpr double kEpsilon = 1e-9;
+
+// Local search over a set of depot-anchored routes. Routes hold customers
+// only; the depot is implied at both ends. Per-node route/position and
+// prefix loads make every move evaluation O(1).
+class FleetSearch {
+public:
+  FleetSearch(const VehicleRoutingProblem& problem,
+              const std::vector<int>& neighbors, size_t k)
+      : problem_(problem), neighbors_(neighbors), k_(k), depot_(problem.depot) {}
+
+  void improve(std::vector<std::vector<int>>& routes, std::mt19937& rng);
+
+private:
+  const VehicleRoutingProblem& problem_;
+  const std::vector<int>& neighbors_;
+  const size_t k_;
+  const int depot_;
+
+  std::vector<std::vector<int>> routes_;
+  std::vector<int> routeOf_;
+  std::vector<int> posOf_;
+  std::vector<double> prefix_;  // load from the route start up to the node
+  std::vector<double> load_;
+
+  double dist(int a, int b) const {
+    return problem_.points[a].distanceTo(problem_.points[b]);
+  }
+  double demand(int v) const { return problem_.demands[v]; }
+  bool fits(double load) const { return load <= problem_.vehicleCapacity + kEpsilon; }
+
+  int pred(int u) const {
+    return posOf_[u] == 0 ? depot_ : routes_[routeOf_[u]][posOf_[u] - 1];
+  }
+  int succ(int u) const {
+    const auto& route = routes_[routeOf_[u]];
+    return posOf_[u] + 1 == int(route.size()) ? depot_ : route[posOf_[u] + 1];
+  }
+
+  void refresh(int r);
+  bool relocate(int u, int r, int at);
+  bool trySwap(int u, int v);
+  bool tryTwoOpt(int u, int v);
+  bool tryTwoOptStar(int u, int r, int head);
+};
+
+void FleetSearch::refresh(int r) {
+  double load = 0.0;
+  const auto& route = routes_[r];
+  for (size_t i = 0; i < route.size(); ++i) {
+    routeOf_[route[i]] = r;
+    posOf_[route[i]] = i;
+    load += demand(route[i]);
+    prefix_[route[i]] = load;
+  }
+  load_[r] = load;
+}
+
+// Moves u to index `at` of route r (an index into r before u is removed).
+bool FleetSearch::relocate(int u, int r, int at) {
+  const int ru = routeOf_[u];
+  const auto& target = routes_[r];
+  const int a = at == 0 ? depot_ : target[at - 1];
+  const int b = at == int(target.size()) ? depot_ : target[at];
+  if (a == u || b == u) return false;
+  if (r != ru && !fits(load_[r] + demand(u))) return false;
+
+  const int pu = pred(u), su = succ(u);
+  const double delta = dist(pu, su) - dist(pu, u) - dist(u, su)
+                     + dist(a, u) + dist(u, b) - dist(a, b);
+  if (delta >= -kEpsilon) return false;
+
+  const int from = posOf_[u];
+  routes_[ru].erase(routes_[ru].begin() + from);
+  if (r == ru && from < at) --at;
+  routes_[r].insert(routes_[r].begin() + at, u);
+  refresh(ru);
+  if (r != ru) refresh(r);
+  return true;
+}
+
+bool FleetSearch::trySwap(int u, int v) {
+  const int ru = routeOf_[u], rv = routeOf_[v];
+  if (ru == rv && std::abs(posOf_[u] - posOf_[v]) <= 1) return false;
+  if (ru != rv && (!fits(load_[ru] - demand(u) + demand(v)) ||
+                   !fits(load_[rv] - demand(v) + demand(u)))) {
+    return false;
+  }
+
+  const int pu = pred(u), su = succ(u), pv = pred(v), sv = succ(v);
+  const double delta = dist(pu, v) + dist(v, su) - dist(pu, u) - dist(u, su)
+                     + dist(pv, u) + dist(u, sv) - dist(pv, v) - dist(v, sv);
+  if (delta >= -kEpsilon) return false;
+
+  std::swap(routes_[ru][posOf_[u]], routes_[rv][posOf_[v]]);
+  refresh(ru);
+  if (rv != ru) refresh(rv);
+  return true;
+}
+
+// Intra-route 2-opt making u and v adjacent.
+bool FleetSearch::tryTwoOpt(int u, int v) {
+  if (posOf_[u] > posOf_[v]) std::swap(u, v);
+  const int su = succ(u), sv = succ(v);
+  if (su == v) return false;
+
+  const double delta = dist(u, v) + dist(su, sv) - dist(u, su) - dist(v, sv);
+  if (delta >= -kEpsilon) return false;
+
+  auto& route = routes_[routeOf_[u]];
+  std::reverse(route.begin() + posOf_[u] + 1, route.begin() + posOf_[v] + 1);
+  refresh(routeOf_[u]);
+  return true;
+}
+
+// 2-opt*: exchanges the tail after u with the tail of route r after index
+// `head` (-1 hands over the whole of route r).
+bool FleetSearch::tryTwoOptStar(int u, int r, int head) {
+  const int ru = routeOf_[u];
+  auto& other = routes_[r];
+  const int v = head < 0 ? depot_ : other[head];
+  const int sv = head + 1 == int(other.size()) ? depot_ : other[head + 1];
+  const int su = succ(u);
+  if (su == depot_ && sv == depot_) return false;
+
+  const double headV = head < 0 ? 0.0 : prefix_[v];
+  if (!fits(prefix_[u] + load_[r] - headV) || !fits(headV + load_[ru] - prefix_[u])) {
+    return false;
+  }
+
+  const double delta = dist(u, sv) + dist(v, su) - dist(u, su) - dist(v, sv);
+  if (delta >= -kEpsilon) return false;
+
+  auto& mine = routes_[ru];
+  std::vector<int> tail(mine.begin() + posOf_[u] + 1, mine.end());
+  mine.resize(posOf_[u] + 1);
+  mine.insert(mine.end(), other.begin() + head + 1, other.end());
+  other.resize(head + 1);
+  other.insert(other.end(), tail.begin(), tail.end());
+  refresh(ru);
+  refresh(r);
+  return true;
+}
+
+void FleetSearch::improve(std::vector<std::vector<int>>& routes, std::mt19937& rng) {
+  const size_t n = problem_.points.size();
+  routes_ = std::move(routes);
+  routeOf_.assign(n, -1);
+  posOf_.assign(n, -1);
+  prefix_.assign(n, 0.0);
+  load_.assign(routes_.size(), 0.0);
+  for (size_t r = 0; r < routes_.size(); ++r) {
+    refresh(r);
+  }
+
+  std::vector<int> order;
+  for (size_t v = 0; v < n; ++v) {
+    if (int(v) != depot_) order.push_back(v);
+  }
+  std::shuffle(order.begin(), order.end(), rng);
+
+  // First improvement: for each customer u, try to make u adjacent to one
+  // of its nearest neighbours v through any of the move types.
+  bool improved = true;
+  while (improved) {
+    improved = false;
+    for (int u : order) {
+      for (size_t i = 0; i < k_; ++i) {
+        const int v = neighbors_[u * k_ + i];
+        if (v < 0) break;
+        if (v == depot_) continue;
+
+        const int rv = routeOf_[v], pv = posOf_[v];
+        const bool moved =
+            relocate(u, rv, pv + 1) || relocate(u, rv, pv) || trySwap(u, v) ||
+            (routeOf_[u] == rv ? tryTwoOpt(u, v) : tryTwoOptStar(u, rv, pv - 1));
+        if (moved) {
+          improved = true;
+          break;
+        }
+      }
+    }
+  }
+
+  routes_.erase(std::remove_if(routes_.begin(), routes_.end(),
+                               [](const std::vector<int>& r) { return r.empty(); }),
+                routes_.end());
+  routes = std::move(routes_);
+}
+
+// Empties the lightest route into the others, cheapest feasible insertion
+// first, until at most `vehicles` routes remain. Returns false when a stop
+// fits in no other route.
+bool reduceFleet(const VehicleRoutingProblem& problem, std::vector<std::vector<int>>& routes,
+                 size_t vehicles) {
+  auto dist = [&problem](int a, int b) {
+    return problem.points[a].distanceTo(problem.points[b]);
+  };
+  std::vector<double> load(routes.size(), 0.0);
+  for (size_t r = 0; r < routes.size(); ++r) {
+    for (int v : routes[r]) load[r] += problem.demands[v];
+  }
+
+  while (routes.size() > vehicles) {
+    const size_t lightest = std::min_element(load.begin(), load.end()) - load.begin();
+    std::vector<int> stops = std::move(routes[lightest]);
+    routes.erase(routes.begin() + lightest);
+    load.erase(load.begin() + lightest);
+    std::sort(stops.begin(), stops.end(), [&problem](int a, int b) {
+      return problem.demands[a] > problem.demands[b];
+    });
+
+    for (int u : stops) {
+      double best = std::numeric_limits<double>::infinity();
+      size_t bestRoute = 0, bestAt = 0;
+      for (size_t r = 0; r < routes.size(); ++r) {
+        if (load[r] + problem.demands[u] > problem.vehicleCapacity + kEpsilon) continue;
+        const auto& route = routes[r];
+        for (size_t at = 0; at <= route.size(); ++at) {
+          const int a = at == 0 ? problem.depot : route[at - 1];
+          const int b = at == route.size() ? problem.depot : route[at];
+          const double delta = dist(a, u) + dist(u, b) - dist(a, b);
+          if (delta < best) {
+            best = delta;
+            bestRoute = r;
+            bestAt = at;
+          }
+        }
+      }
+      if (best == std::numeric_limits<double>::infinity()) return false;
+      routes[bestRoute].insert(routes[bestRoute].begin() + bestAt, u);
+      load[bestRoute] += problem.demands[u];
+    }
+  }
+  return true;
+}
+
+double routeLength(const VehicleRoutingProblem& problem, const std::vector<int>& route) {
+  double total = 0.0;
+  int prev = problem.depot;
+  for (int v : route) {
+    total += problem.points[prev].distanceTo(problem.points[v]);
+    prev = v;
+  }
+  return total + problem.points[prev].distanceTo(problem.points[problem.depot]);
+}
+} // namespace
+
+CVRPSolver::CVRPSolver(const CVRPConfig& config) : config_(config) {}
+
+std::vector<std::vector<int>> CVRPSolver::savings(const VehicleRoutingProblem& problem,
+                                                  const std::vector<int>& neighbors,
+                                                  size_t k, double shape) const {
+  const int n = static_cast<int>(problem.points.size());
+  const int depot = problem.depot;
+  auto dist = [&problem](int a, int b) {
+    return problem.points[a].distanceTo(problem.points[b]);
+  };
+
+  // Savings s(i,j) = d(0,i) + d(0,j) - shape * d(i,j), over candidate pairs
+  // only so that construction stays O(n k log(n k)).
+  struct Saving {
+    double value;
+    int i, j;
+  };
+  std::vector<Saving> pairs;
+  pairs.reserve(n * k);
+  for (int i = 0; i < n; ++i) {
+    if (i == depot) continue;
+    for (size_t a = 0; a < k; ++a) {
+      const int j = neighbors[i * k + a];
+      if (j < 0) break;
+      if (j == depot) continue;
+      const int* row = &neighbors[j * k];
+      if (j < i && std::find(row, row + k, i) != row + k) continue;
+      const double value = dist(depot, i) + dist(depot, j) - shape * dist(i, j);
+      if (value > 0.0) pairs.push_back({value, i, j});
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const Saving& l, const Saving& r) { return l.value > r.value; });
+
+  std::vector<std::vector<int>> routes(n);
+  std::vector<int> routeOf(n);
+  std::vector<double> load(n, 0.0);
+  for (int v = 0; v < n; ++v) {
+    if (v == depot) continue;
+    routes[v] = {v};
+    routeOf[v] = v;
+    load[v] = problem.demands[v];
+  }
+
+  // Merge two routes whenever i and j are route ends and the combined load
+  // fits a vehicle.
+  for (const auto& s : pairs) {
+    const int ri = routeOf[s.i], rj = routeOf[s.j];
+    if (ri == rj || load[ri] + load[rj] > problem.vehicleCapacity + kEpsilon) continue;
+
+    auto& a = routes[ri];
+    auto& b = routes[rj];
+    if (a.back() != s.i) {
+      if (a.front() != s.i) continue;
+      std::reverse(a.begin(), a.end());
+    }
+    if (b.front() != s.j) {
+      if (b.back() != s.j) continue;
+      std::reverse(b.begin(), b.end());
+    }
+
+    for (int v : b) routeOf[v] = ri;
+    a.insert(a.end(), b.begin(), b.end());
+    load[ri] += load[rj];
+    b.clear();
+  }
+
+  routes.erase(std::remove_if(routes.begin(), routes.end(),
+                              [](const std::vector<int>& r) { return r.empty(); }),
+               routes.end());
+  return routes;
+}
+
+FleetSolution CVRPSolver::solve(const VehicleRoutingProblem& problem) const {
+  const size_t n = problem.points.size();
+  if (problem.demands.size() != n) {
+    throw std::invalid_argument("Expected one demand per point");
+  }
+  if (problem.depot < 0 || size_t(problem.depot) >= n) {
+    throw std::invalid_argument("Depot index out of range");
+  }
+  for (size_t v = 0; v < n; ++v) {
+    if (int(v) != problem.depot &&
+        (problem.demands[v] < 0.0 || problem.demands[v] > problem.vehicleCapacity)) {
+      throw std::invalid_argument("Demand exceeds vehicle capacity");
+    }
+  }
+  if (problem.vehicles > 0) {
+    double total = 0.0;
+    for (size_t v = 0; v < n; ++v) {
+      if (int(v) != problem.depot) total += problem.demands[v];
+    }
+    if (total > problem.vehicles * problem.vehicleCapacity + kEpsilon) {
+      throw std::invalid_argument("Total demand exceeds the capacity of the fleet");
+    }
+  }
+
+  FleetSolution solution;
+  if (n < 2) {
+    return solution;
+  }
+
+  const size_t k = std::min(config_.candidateNeighbors, n - 1);
+  const auto neighbors = SpatialGrid(problem.points).nearestNeighbors(k);
+
+  const long starts = static_cast<long>(
+      config_.starts ? config_.starts
+                     : std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::vector<std::vector<int>>> results(starts);
+  std::vector<double> costs(starts, 0.0);
+  std::vector<size_t> fleet(starts, 0);
+
+  // Each start uses a different savings shape parameter and search order.
+#pragma omp parallel for schedule(dynamic)
+  for (long s = 0; s < starts; ++s) {
+    const double shape = starts == 1 ? 1.0 : 0.6 + 1.2 * double(s) / double(starts - 1);
+    std::mt19937 rng(config_.seed + s);
+
+    auto routes = savings(problem, neighbors, k, shape);
+    fleet[s] = routes.size();
+    if (problem.vehicles > 0 && !reduceFleet(problem, routes, problem.vehicles)) {
+      costs[s] = std::numeric_limits<double>::infinity();
+      continue;
+    }
+    FleetSearch(problem, neighbors, k).improve(routes, rng);
+
+    for (const auto& route : routes) {
+      costs[s] += routeLength(problem, route);
+    }
+    results[s] = std::move(routes);
+  }
+
+  const size_t best = std::min_element(costs.begin(), costs.end()) - costs.begin();
+  if (costs[best] == std::numeric_limits<double>::infinity()) {
+    throw std::runtime_error("Could not fit the stops into " + std::to_string(problem.vehicles) +
+                             " vehicles; savings needed " +
+                             std::to_string(*std::min_element(fleet.begin(), fleet.end())));
+  }
+  for (auto& customers : results[best]) {
+    Route route;
+    route.path.reserve(customers.size() + 1);
+    route.path.push_back(problem.depot);
+    route.path.insert(route.path.end(), customers.begin(), customers.end());
+    route.totalDistance = routeLength(problem, customers);
+    solution.totalDistance += route.totalDistance;
+    solution.routes.push_back(std::move(route));
+  }
+  return solution;
+}
+
+}; // namespace route_opt
@@ -0,0 +1,45 @@
+#include "workspace.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace route_opt {
+
+Arena::Arena(size_t initialSize) : initialSize_(std::max<size_t>(initialSize, 64)) {}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+  for (;; ++current_, offset_ = 0) {
+    if (current_ == blocks_.size()) {
+      // Grow geometrically so that a solve needs few blocks before reset()
+      // merges them.
+      const size_t previous = blocks_.empty() ? initialSize_ / 2 : blocks_.back().size;
+      const size_t size = std::max(2 * previous, bytes + alignment);
+      blocks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    }
+
+    Block& block = blocks_[current_];
+    const auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+    const size_t start = ((base + offset_ + alignment - 1) & ~std::uintptr_t(alignment - 1)) - base;
+    if (start + bytes <= block.size) {
+      offset_ = start + bytes;
+      return block.data.get() + start;
+    }
+  }
+}
+
+void Arena::reset() {
+  if (blocks_.size() > 1) {
+    const size_t total = capacity();
+    blocks_.clear();
+    blocks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[total]), total});
+  }
+  current_ = 0;
+  offset_ = 0;
+}
+
+size_t Arena::capacity() const {
+  size_t total = 0;
+  for (const auto& block : blocks_) total += block.size;
+  return total;
+}
+
+}; // namespace route_opt
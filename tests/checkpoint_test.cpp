@@ -0,0 +1,109 @@
+#include "decomposition.h"
+#include "local_search.h"
+#include "memetic.h"
+#include "route_generator.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+using namespace route_opt;
+
+namespace {
+
+int expectSame(const Route& resumed, const Route& reference, const char* what) {
+  if (resumed.path != reference.path) {
+    std::fprintf(stderr, "%s: resumed tour differs (%.1f vs %.1f)\n", what,
+                 resumed.totalDistance, reference.totalDistance);
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "route_opt_checkpoint_test.ckpt").string();
+
+  RouteGenerator generator(9);
+  GeneratorConfig config;
+
+  // Memetic: stopping on stalled migrations instead of the clock makes the
+  // run repeatable, and every epoch is offered to the writer.
+  config.numPoints = 300;
+  const PointVector small = generator.generateRandomEuclidean(config).first;
+  MemeticConfig memetic;
+  memetic.islands = 2;
+  memetic.populationSize = 8;
+  memetic.migrationInterval = 5;
+  memetic.stallMigrations = 3;
+  memetic.timeLimit = 600.0;
+  memetic.checkpointPath = path;
+  memetic.checkpointInterval = 0.0;
+  const Route full = MemeticOptimizer(memetic).findOptimalRoute(small);
+  memetic.checkpointPath.clear();
+  memetic.resumePath = path;
+  failures += expectSame(MemeticOptimizer(memetic).findOptimalRoute(small), full, "memetic");
+
+  // Decomposition: a run that fails part way through the clusters, then one
+  // that finishes and leaves its stitched tour behind.
+  config.numPoints = 5000;
+  const PointVector large = generator.generateRandomEuclidean(config).first;
+  DecompositionConfig decomposition;
+  decomposition.clusterSize = 500;
+  // Counts the cluster optimisers created; past `budget` creation fails,
+  // standing in for a run that is killed part way through.
+  std::atomic<int> created{0};
+  int budget = 1 << 30;
+  auto factory = [&created, &budget]() -> RouteOptimizer* {
+    if (created++ >= budget) throw std::runtime_error("interrupted");
+    return new LocalSearchOptimizer();
+  };
+  const Route reference = DecompositionOptimizer(factory, decomposition).findOptimalRoute(large);
+  const int solves = created;
+
+  decomposition.checkpointPath = path;
+  decomposition.checkpointInterval = 0.0;
+  created = 0;
+  budget = solves / 2;
+  try {
+    DecompositionOptimizer(factory, decomposition).findOptimalRoute(large);
+    std::fprintf(stderr, "decomposition: interrupted run did not fail\n");
+    ++failures;
+  } catch (const std::runtime_error&) {
+  }
+
+  created = 0;
+  budget = 1 << 30;
+  decomposition.resumePath = path;
+  failures += expectSame(DecompositionOptimizer(factory, decomposition).findOptimalRoute(large),
+                         reference, "decomposition clusters");
+  if (created >= solves) {
+    std::fprintf(stderr, "decomposition: resume solved every cluster again\n");
+    ++failures;
+  }
+
+  // The finished run above saved its stitched tour, so only repair remains.
+  decomposition.checkpointPath.clear();
+  created = 0;
+  failures += expectSame(DecompositionOptimizer(factory, decomposition).findOptimalRoute(large),
+                         reference, "decomposition stitched");
+  if (created != 0) {
+    std::fprintf(stderr, "decomposition: stitched resume solved clusters again\n");
+    ++failures;
+  }
+
+  try {
+    memetic.resumePath = path;
+    MemeticOptimizer(memetic).findOptimalRoute(small);
+    std::fprintf(stderr, "memetic resumed from a decomposition checkpoint\n");
+    ++failures;
+  } catch (const std::runtime_error&) {
+  }
+
+  std::filesystem::remove(path);
+  return failures == 0 ? 0 : 1;
+}
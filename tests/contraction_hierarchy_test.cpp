@@ -0,0 +1,117 @@
+#include "contraction_hierarchy.h"
+#include "route_generator.h"
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace route_opt;
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// Plain Dijkstra over the graph, the reference for every hierarchy query.
+std::vector<double> dijkstra(const RoadGraph& graph, int source) {
+  std::vector<double> distance(graph.nodeCount(), kInfinity);
+  using Entry = std::pair<double, int>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+  distance[source] = 0.0;
+  heap.push({0.0, source});
+  while (!heap.empty()) {
+    const auto [d, v] = heap.top();
+    heap.pop();
+    if (d > distance[v]) continue;
+    for (int a = graph.offsets()[v]; a < graph.offsets()[v + 1]; ++a) {
+      const int w = graph.targets()[a];
+      if (d + graph.weights()[a] < distance[w]) {
+        distance[w] = d + graph.weights()[a];
+        heap.push({distance[w], w});
+      }
+    }
+  }
+  return distance;
+}
+
+int compare(const RoadGraph& graph, const std::vector<int>& sources,
+            const std::vector<int>& targets, const char* what) {
+  const auto matrix = ContractionHierarchy(graph).manyToMany(sources, targets);
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const auto expected = dijkstra(graph, sources[i]);
+    for (size_t j = 0; j < targets.size(); ++j) {
+      const double want = expected[targets[j]];
+      const double got = matrix[i][j];
+      const bool same = std::isinf(want) ? std::isinf(got)
+                                         : std::abs(got - want) <= 1e-9 * (1.0 + want);
+      if (!same) {
+        std::fprintf(stderr, "%s: %d -> %d is %f, Dijkstra says %f\n", what, sources[i],
+                     targets[j], got, want);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+
+  // Synthetic city with one-way streets.
+  GeneratorConfig config;
+  config.numPoints = 3000;
+  RouteGenerator generator(13);
+  const RoadGraph city = generator.generateRoadGraph(config);
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> node(0, static_cast<int>(city.nodeCount()) - 1);
+  std::vector<int> sources(40), targets(60);
+  for (int& v : sources) v = node(rng);
+  for (int& v : targets) v = node(rng);
+  failures += compare(city, sources, targets, "city");
+
+  // Two two-way triangles joined by a single one-way arc 2 -> 3: the left
+  // side reaches the right one but not the other way round.
+  const PointVector corners = {{0, 0}, {1, 0}, {0.5, 1}, {10, 0}, {11, 0}, {10.5, 1}};
+  std::vector<RoadGraph::Arc> arcs;
+  for (int base : {0, 3}) {
+    for (int a = 0; a < 3; ++a) {
+      const int b = (a + 1) % 3;
+      arcs.push_back({base + a, base + b, 1.0 + a});
+      arcs.push_back({base + b, base + a, 1.0 + a});
+    }
+  }
+  arcs.push_back({2, 3, 5.0});
+  const RoadGraph split(corners, arcs);
+  const std::vector<int> all = {0, 1, 2, 3, 4, 5};
+  failures += compare(split, all, all, "one-way bridge");
+
+  const auto matrix = ContractionHierarchy(split).manyToMany({0}, {4});
+  const auto back = ContractionHierarchy(split).manyToMany({4}, {0});
+  if (!std::isfinite(matrix[0][0]) || !std::isinf(back[0][0])) {
+    std::fprintf(stderr, "one-way bridge: expected 0 -> 4 finite and 4 -> 0 unreachable\n");
+    ++failures;
+  }
+
+  // Matrices for optimisers must not carry the unreachable pair.
+  const PointVector stops = {{0.1, 0.1}, {10.9, 0.1}};
+  try {
+    generator.generateRoadNetwork(split, stops);
+    std::fprintf(stderr, "generateRoadNetwork accepted an unreachable pair\n");
+    ++failures;
+  } catch (const std::runtime_error&) {
+  }
+  try {
+    generator.generateRoadNetwork(split, stops, DistancePrecision::Int32, 0.01);
+    std::fprintf(stderr, "quantized generateRoadNetwork accepted an unreachable pair\n");
+    ++failures;
+  } catch (const std::runtime_error&) {
+  }
+
+  return failures == 0 ? 0 : 1;
+}
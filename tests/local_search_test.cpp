@@ -0,0 +1,175 @@
+#include "local_search.h"
+#include "quantized.h"
+#include "route_generator.h"
+#include "spatial_index.h"
+#include <cmath>
+#include <cstdio>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+using namespace route_opt;
+
+namespace {
+
+int checkPermutation(const Route& route, size_t n, const char* what) {
+  std::vector<int> seen(n, 0);
+  for (int v : route.path) {
+    if (v < 0 || size_t(v) >= n || seen[v]++) {
+      std::fprintf(stderr, "%s: path is not a permutation\n", what);
+      return 1;
+    }
+  }
+  if (route.path.size() != n) {
+    std::fprintf(stderr, "%s: path has %zu of %zu nodes\n", what, route.path.size(), n);
+    return 1;
+  }
+  if (!(route.totalDistance > 0.0) || !std::isfinite(route.totalDistance)) {
+    std::fprintf(stderr, "%s: totalDistance %f\n", what, route.totalDistance);
+    return 1;
+  }
+  return 0;
+}
+
+// The search starts from the greedy tour under the same metric, so it must
+// end strictly shorter on a few hundred random points; a metric that was
+// ignored or a search that never moved would not.
+template <typename Metric>
+int checkImproves(const Metric& metric, const Route& route, const char* what) {
+  const PointVector& points = metric.points();
+  const size_t k = LocalSearchConfig{}.candidateNeighbors;
+  const std::vector<int> neighbors = SpatialGrid(points).nearestNeighbors(k);
+  std::vector<int> greedy(points.size());
+  greedyTour(metric, neighbors.data(), k, greedy.data(), std::pmr::get_default_resource());
+  const double start = utils::tourLength(metric, greedy);
+  const double length = utils::tourLength(metric, route.path);
+  if (!(length < start) || std::abs(length - route.totalDistance) > 1e-9 * length) {
+    std::fprintf(stderr, "%s: length %f (reported %f), greedy tour %f\n", what, length,
+                 route.totalDistance, start);
+    return 1;
+  }
+  return 0;
+}
+
+// Row-by-row construction must store exactly what the whole-matrix one does.
+int checkRows(const std::vector<std::vector<double>>& distances, DistancePrecision precision) {
+  const QuantizedMatrix whole(distances, precision, 0.01);
+  QuantizedMatrix rows(distances.size(), precision, 0.01);
+  for (size_t a = 0; a < distances.size(); ++a) rows.setRow(a, distances[a].data());
+  for (size_t a = 0; a < distances.size(); ++a) {
+    for (size_t b = 0; b < distances.size(); ++b) {
+      if (whole.quanta(a, b) != rows.quanta(a, b)) {
+        std::fprintf(stderr, "setRow differs at (%zu, %zu)\n", a, b);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+
+  GeneratorConfig config;
+  config.numPoints = 300;
+  RouteGenerator generator(5);
+  const PointVector points = generator.generateRandomEuclidean(config).first;
+
+  const std::pair<MetricKind, const char*> metrics[] = {
+      {MetricKind::Euclidean, "euclidean"},
+      {MetricKind::RoundedEuclidean, "rounded euclidean"},
+      {MetricKind::Manhattan, "manhattan"},
+  };
+  for (const auto& [metric, name] : metrics) {
+    LocalSearchConfig searchConfig;
+    searchConfig.metric = metric;
+    const Route route = LocalSearchOptimizer(searchConfig).findOptimalRoute(points);
+    failures += checkPermutation(route, points.size(), name);
+    switch (metric) {
+      case MetricKind::Euclidean:
+        failures += checkImproves(EuclideanMetric(points), route, name);
+        break;
+      case MetricKind::RoundedEuclidean:
+        failures += checkImproves(RoundedEuclideanMetric(points), route, name);
+        break;
+      case MetricKind::Manhattan:
+        failures += checkImproves(ManhattanMetric(points), route, name);
+        break;
+      default:
+        break;
+    }
+
+    // Rounded lengths add up to an exact integer.
+    if (metric == MetricKind::RoundedEuclidean) {
+      double rounded = 0.0;
+      for (size_t i = 0; i < route.path.size(); ++i) {
+        const Point& a = points[route.path[i]];
+        const Point& b = points[route.path[(i + 1) % route.path.size()]];
+        rounded += std::lround(std::hypot(a.x - b.x, a.y - b.y));
+      }
+      if (route.totalDistance != rounded) {
+        std::fprintf(stderr, "%s: totalDistance %f, sum of nint edges %f\n", name,
+                     route.totalDistance, rounded);
+        ++failures;
+      }
+    }
+  }
+
+  // Latitude in x, longitude in y.
+  PointVector places(points.size());
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> latitude(40.0, 50.0), longitude(-5.0, 5.0);
+  for (auto& p : places) p = Point{latitude(rng), longitude(rng)};
+  LocalSearchConfig geographic;
+  geographic.metric = MetricKind::Geographic;
+  const Route geoRoute = LocalSearchOptimizer(geographic).findOptimalRoute(places);
+  failures += checkPermutation(geoRoute, places.size(), "geographic");
+  failures += checkImproves(GeoMetric(places), geoRoute, "geographic");
+
+  // Asymmetric matrix at every precision; totalDistance comes from the
+  // caller's doubles.
+  const auto distances = generator.generateRoadNetwork(points);
+  const std::pair<DistancePrecision, const char*> precisions[] = {
+      {DistancePrecision::Double, "matrix double"},
+      {DistancePrecision::Int32, "matrix int32"},
+      {DistancePrecision::UInt16, "matrix uint16"},
+  };
+  for (const auto& [precision, name] : precisions) {
+    LocalSearchConfig searchConfig;
+    searchConfig.precision = precision;
+    const Route route = LocalSearchOptimizer(searchConfig).findOptimalRouteForMatrix(distances);
+    failures += checkPermutation(route, distances.size(), name);
+    if (std::abs(route.totalDistance - utils::tourLength(distances, route.path)) >
+        1e-9 * route.totalDistance) {
+      std::fprintf(stderr, "%s: totalDistance does not match the path\n", name);
+      ++failures;
+    }
+  }
+
+  failures += checkRows(distances, DistancePrecision::Int32);
+  failures += checkRows(distances, DistancePrecision::UInt16);
+
+  // A quantized road-graph matrix, never held as doubles, solves directly.
+  config.numPoints = 2000;
+  const RoadGraph graph = generator.generateRoadGraph(config);
+  const PointVector stops(points.begin(), points.begin() + 100);
+  const auto exact = generator.generateRoadNetwork(graph, stops);
+  const QuantizedMatrix quantized =
+      generator.generateRoadNetwork(graph, stops, DistancePrecision::Int32, 0.01);
+  for (size_t a = 0; a < stops.size(); ++a) {
+    for (size_t b = 0; b < stops.size(); ++b) {
+      if (std::abs(quantized.distance(a, b) - exact[a][b]) > 0.005 + 1e-9) {
+        std::fprintf(stderr, "quantized road matrix differs at (%zu, %zu)\n", a, b);
+        ++failures;
+        a = stops.size();
+        break;
+      }
+    }
+  }
+  failures += checkPermutation(LocalSearchOptimizer().findOptimalRouteForMatrix(quantized),
+                               stops.size(), "quantized road matrix");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include "lower_bound.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace route_opt;
+
+namespace {
+
+// Shortest tour by enumerating every permutation that starts at node 0.
+double bruteForceOptimum(const PointVector& points) {
+  std::vector<int> order(points.size());
+  std::iota(order.begin(), order.end(), 0);
+  double best = std::numeric_limits<double>::infinity();
+  do {
+    double length = 0.0;
+    for (size_t i = 0; i < order.size(); ++i) {
+      length += points[order[i]].distanceTo(points[order[(i + 1) % order.size()]]);
+    }
+    best = std::min(best, length);
+  } while (std::next_permutation(order.begin() + 1, order.end()));
+  return best;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> coordinate(0.0, 100.0);
+  std::uniform_real_distribution<double> offset(0.0, 1.0);
+
+  for (size_t n = 3; n <= 9; ++n) {
+    for (int trial = 0; trial < 10; ++trial) {
+      // Odd trials form two tight clusters, which disconnects the candidate
+      // graph at small k and exercises the bridging edges.
+      PointVector points(n);
+      for (size_t i = 0; i < n; ++i) {
+        points[i] = trial % 2 == 0 ? Point{coordinate(rng), coordinate(rng)}
+                                   : Point{(i % 2) * 100.0 + offset(rng), offset(rng)};
+      }
+      const double optimum = bruteForceOptimum(points);
+
+      for (size_t k : {2, 10}) {
+        LowerBoundConfig config;
+        config.candidateNeighbors = k;
+        const auto result = HeldKarpBound(config).compute(points);
+        if (!result.certified || result.bound > optimum * (1.0 + 1e-9)) {
+          std::fprintf(stderr, "n=%zu trial=%d k=%zu: bound %.6f above optimum %.6f\n",
+                       n, trial, k, result.bound, optimum);
+          ++failures;
+        }
+        if (optimalityGap(optimum, result.bound) < -1e-9) {
+          std::fprintf(stderr, "n=%zu trial=%d k=%zu: negative gap\n", n, trial, k);
+          ++failures;
+        }
+      }
+
+      const double certified = certifiedLowerBound(points);
+      if (!(certified > 0.0) || certified > optimum * (1.0 + 1e-9)) {
+        std::fprintf(stderr, "n=%zu trial=%d: certifiedLowerBound %.6f, optimum %.6f\n", n,
+                     trial, certified, optimum);
+        ++failures;
+      }
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
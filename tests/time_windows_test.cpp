@@ -0,0 +1,128 @@
+#include "route_generator.h"
+#include "time_windows.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace route_opt;
+
+namespace {
+
+TimeWindowProblem makeProblem(size_t n, size_t slots, unsigned seed) {
+  GeneratorConfig config;
+  config.numPoints = n;
+  config.numTimeSlots = slots;
+  RouteGenerator generator(seed);
+  const PointVector points = generator.generateRandomEuclidean(config).first;
+  TimeWindowProblem problem;
+  problem.travelTimes = generator.generateTimeDependent(points, config);
+  problem.windows.resize(n);
+  return problem;
+}
+
+// Checks the shape of a solution and that it reports its own schedule.
+int checkSolution(const TimeWindowProblem& problem, const ScheduledRoute& solution,
+                  const char* what) {
+  const size_t n = problem.windows.size();
+  const auto& path = solution.route.path;
+  std::vector<int> seen(n, 0);
+  for (int v : path) {
+    if (v < 0 || size_t(v) >= n || seen[v]++) {
+      std::fprintf(stderr, "%s: path is not a permutation\n", what);
+      return 1;
+    }
+  }
+  if (path.size() != n || path.front() != problem.depot) {
+    std::fprintf(stderr, "%s: path must visit all %zu nodes from the depot\n", what, n);
+    return 1;
+  }
+  const ScheduledRoute exact = TimeWindowOptimizer().evaluate(problem, path);
+  if (std::abs(exact.route.totalDistance - solution.route.totalDistance) > 1e-6 ||
+      std::abs(exact.timeWarp - solution.timeWarp) > 1e-6) {
+    std::fprintf(stderr, "%s: reports travel %f warp %f, evaluate() gives %f and %f\n", what,
+                 solution.route.totalDistance, solution.timeWarp, exact.route.totalDistance,
+                 exact.timeWarp);
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+  const TimeWindowOptimizer optimizer;
+
+  // Loose and tight random windows, with several slots and with one.
+  for (size_t slots : {24, 1}) {
+    for (double width : {5000.0, 300.0}) {
+      TimeWindowProblem problem = makeProblem(200, slots, 3);
+      std::mt19937 rng(7);
+      std::uniform_real_distribution<double> open(0.0, 4000.0);
+      for (size_t v = 1; v < problem.windows.size(); ++v) {
+        const double earliest = open(rng);
+        problem.windows[v] = {earliest, earliest + width, 2.0};
+      }
+      failures += checkSolution(problem, optimizer.solve(problem), "random windows");
+    }
+  }
+
+  // Windows built around the schedule of a shuffled order admit it, so the
+  // solver must find some order without lateness.
+  {
+    TimeWindowProblem problem = makeProblem(150, 24, 5);
+    std::vector<int> order(problem.windows.size());
+    for (size_t v = 0; v < order.size(); ++v) order[v] = int(v);
+    std::shuffle(order.begin() + 1, order.end(), std::mt19937(9));
+    for (size_t v = 1; v < order.size(); ++v) problem.windows[v].serviceTime = 2.0;
+    const ScheduledRoute planned = optimizer.evaluate(problem, order);
+    for (size_t p = 1; p < order.size(); ++p) {
+      TimeWindow& w = problem.windows[order[p]];
+      w.earliest = planned.startTimes[p] - 20.0;
+      w.latest = planned.startTimes[p] + 20.0;
+    }
+    const ScheduledRoute solution = optimizer.solve(problem);
+    failures += checkSolution(problem, solution, "feasible windows");
+    if (!solution.feasible()) {
+      std::fprintf(stderr, "feasible windows: solution has time warp %f\n", solution.timeWarp);
+      ++failures;
+    }
+  }
+
+  // Small instances under a single slot: the search must reach the best of
+  // every order.
+  for (unsigned seed = 1; seed <= 10; ++seed) {
+    TimeWindowProblem problem = makeProblem(8, 1, seed);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> open(0.0, 300.0);
+    for (size_t v = 1; v < problem.windows.size(); ++v) {
+      const double earliest = open(rng);
+      problem.windows[v] = {earliest, earliest + 150.0, 2.0};
+    }
+
+    std::vector<int> order = {0, 1, 2, 3, 4, 5, 6, 7};
+    ScheduledRoute best = optimizer.evaluate(problem, order);
+    while (std::next_permutation(order.begin() + 1, order.end())) {
+      const ScheduledRoute candidate = optimizer.evaluate(problem, order);
+      if (candidate.timeWarp < best.timeWarp - 1e-9 ||
+          (candidate.timeWarp <= best.timeWarp + 1e-9 &&
+           candidate.route.totalDistance < best.route.totalDistance - 1e-9)) {
+        best = candidate;
+      }
+    }
+
+    const ScheduledRoute solution = optimizer.solve(problem);
+    failures += checkSolution(problem, solution, "brute force");
+    if (std::abs(solution.timeWarp - best.timeWarp) > 1e-6 ||
+        std::abs(solution.route.totalDistance - best.route.totalDistance) > 1e-6) {
+      std::fprintf(stderr, "brute force seed %u: travel %f warp %f, optimum %f and %f\n", seed,
+                   solution.route.totalDistance, solution.timeWarp, best.route.totalDistance,
+                   best.timeWarp);
+      ++failures;
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
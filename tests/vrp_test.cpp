@@ -0,0 +1,91 @@
+#include "route_generator.h"
+#include "vrp.h"
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace route_opt;
+
+namespace {
+
+// Every customer served exactly once, every route starting at the depot and
+// within capacity, and at most `vehicles` routes when the fleet is limited.
+int check(const VehicleRoutingProblem& problem, const FleetSolution& solution) {
+  int failures = 0;
+  std::vector<int> served(problem.points.size(), 0);
+  double total = 0.0;
+  for (const auto& route : solution.routes) {
+    if (route.path.empty() || route.path[0] != problem.depot) {
+      std::fprintf(stderr, "route does not start at the depot\n");
+      ++failures;
+      continue;
+    }
+    double load = 0.0;
+    for (size_t i = 1; i < route.path.size(); ++i) {
+      ++served[route.path[i]];
+      load += problem.demands[route.path[i]];
+    }
+    if (load > problem.vehicleCapacity + 1e-9) {
+      std::fprintf(stderr, "route load %.1f exceeds capacity\n", load);
+      ++failures;
+    }
+    total += route.totalDistance;
+  }
+  for (size_t v = 0; v < served.size(); ++v) {
+    if (served[v] != (int(v) == problem.depot ? 0 : 1)) {
+      std::fprintf(stderr, "stop %zu served %d times\n", v, served[v]);
+      ++failures;
+    }
+  }
+  if (problem.vehicles > 0 && solution.routes.size() > problem.vehicles) {
+    std::fprintf(stderr, "%zu routes for %zu vehicles\n", solution.routes.size(), problem.vehicles);
+    ++failures;
+  }
+  if (std::abs(total - solution.totalDistance) > 1e-6 * total) {
+    std::fprintf(stderr, "totalDistance does not match the routes\n");
+    ++failures;
+  }
+  return failures;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+
+  GeneratorConfig config;
+  config.numPoints = 500;
+  RouteGenerator generator(3);
+  VehicleRoutingProblem problem;
+  problem.points = generator.generateRandomEuclidean(config).first;
+  problem.demands = generator.generateDemands(problem.points.size(), 0, config);
+  problem.vehicleCapacity = 50.0;
+
+  CVRPConfig solverConfig;
+  solverConfig.starts = 4;
+  const CVRPSolver solver(solverConfig);
+  const auto unlimited = solver.solve(problem);
+  failures += check(problem, unlimited);
+
+  // The smallest fleet the total demand allows, which is below what the
+  // savings construction opens on its own.
+  double demand = 0.0;
+  for (double d : problem.demands) demand += d;
+  problem.vehicles = size_t(std::ceil(demand / problem.vehicleCapacity));
+  if (problem.vehicles >= unlimited.routes.size()) {
+    std::fprintf(stderr, "fleet limit not exercised\n");
+    ++failures;
+  }
+  failures += check(problem, solver.solve(problem));
+
+  problem.vehicles = size_t(demand / problem.vehicleCapacity) - 1;
+  try {
+    solver.solve(problem);
+    std::fprintf(stderr, "fleet too small for the total demand was accepted\n");
+    ++failures;
+  } catch (const std::invalid_argument&) {
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include "local_search.h"
+#include "quantized.h"
+#include "route_generator.h"
+#include "workspace.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace route_opt;
+
+// Every heap allocation in the program goes through here.
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// After a first solve has sized the workspace, a repeat solve may only
+// allocate the returned path.
+template <typename Solve>
+int checkSteadyState(Solve&& solve, const char* what) {
+  solve();
+  for (int repeat = 0; repeat < 3; ++repeat) {
+    const long before = allocations;
+    const Route route = solve();
+    const long count = allocations - before;
+    if (count > 1) {
+      std::fprintf(stderr, "%s: repeat solve made %ld heap allocations\n", what, count);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+
+  GeneratorConfig config;
+  config.numPoints = 200;
+  RouteGenerator generator(3);
+  const PointVector points = generator.generateRandomEuclidean(config).first;
+  const auto distances = generator.generateRoadNetwork(points);
+
+  SolverWorkspace workspace;
+  {
+    LocalSearchOptimizer optimizer;
+    optimizer.setWorkspace(&workspace);
+    failures += checkSteadyState(
+        [&] { return optimizer.findOptimalRouteForMatrix(distances); }, "matrix double");
+  }
+
+  // Quantizing doubles builds the matrix, so repeat solves take it prebuilt.
+  const std::pair<DistancePrecision, const char*> precisions[] = {
+      {DistancePrecision::Int32, "matrix int32"},
+      {DistancePrecision::UInt16, "matrix uint16"},
+  };
+  for (const auto& [precision, name] : precisions) {
+    const QuantizedMatrix quantized(distances, precision);
+    LocalSearchOptimizer optimizer;
+    optimizer.setWorkspace(&workspace);
+    failures += checkSteadyState(
+        [&] { return optimizer.findOptimalRouteForMatrix(quantized); }, name);
+  }
+
+  LocalSearchOptimizer optimizer;
+  optimizer.setWorkspace(&workspace);
+  failures += checkSteadyState([&] { return optimizer.findOptimalRoute(points); }, "points");
+
+  return failures == 0 ? 0 : 1;
+}